@@ -1,29 +1,54 @@
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <string_view>
+#include <vector>
 
 #include "boost/algorithm/string.hpp"
 #include "boost/filesystem.hpp"
 
+#include "utl/enumerate.h"
+
+#include "cista/hash.h"
 #include "cista/mmap.h"
 
+#include "step/perfect_hash.h"
+
 #include "express/exp_struct_gen.h"
 #include "express/parse_exp.h"
 
 namespace fs = boost::filesystem;
 
 int main(int argc, char** argv) {
-  if (argc < 3) {
-    std::cout << "usage: " << argv[0] << " EXPRESS_FILE TARGET_DIR\n";
+  auto gen_opt = express::gen_options{};
+  auto args = std::vector<char const*>{};
+  for (auto i = 1; i < argc; ++i) {
+    if (std::string_view{argv[i]} == "--string-ref") {
+      gen_opt.string_ref_ = true;
+    } else if (std::string_view{argv[i]} == "--intern-strings") {
+      gen_opt.intern_strings_ = true;
+    } else if (std::string_view{argv[i]} == "--compact-refs") {
+      gen_opt.compact_refs_ = true;
+    } else {
+      args.emplace_back(argv[i]);
+    }
+  }
+
+  if (args.size() != 2U || (gen_opt.string_ref_ && gen_opt.intern_strings_)) {
+    std::cout << "usage: " << argv[0]
+              << " [--string-ref | --intern-strings] [--compact-refs] "
+                 "EXPRESS_FILE TARGET_DIR\n";
     return 1;
   }
 
-  auto const root = fs::path{argv[2]};
+  auto const root = fs::path{args[1]};
   fs::create_directories(root);
-  if (!fs::is_regular_file(argv[1])) {
-    std::cout << argv[1] << " has to be a file\n";
+  if (!fs::is_regular_file(args[0])) {
+    std::cout << args[0] << " has to be a file\n";
     return 1;
   }
 
-  auto const expr = cista::mmap{argv[1], cista::mmap::protection::READ};
+  auto const expr = cista::mmap{args[0], cista::mmap::protection::READ};
   auto const schema = express::parse(std::string_view{
       reinterpret_cast<char const*>(expr.data()), expr.size()});
 
@@ -33,50 +58,162 @@ int main(int argc, char** argv) {
   auto source_out = std::ofstream{
       (root / (root.stem().generic_string() + ".cc")).generic_string().c_str()};
   source_out << "#include \"step/id_t.h\"\n";
+
+  // Snapshots are only compatible if all generated types are the same.
+  auto schema_hash = cista::BASE_HASH;
+  for (auto const& t : schema.types_) {
+    auto header = std::stringstream{};
+    express::generate_header(header, schema, t, gen_opt);
+    schema_hash = cista::hash(header.str(), schema_hash);
+    std::ofstream{(header_path / (t.name_ + ".h")).generic_string().c_str()}
+        << header.str();
+    express::generate_source(source_out, schema, t, gen_opt);
+  }
+
+  // string_ref attributes point into the input: keep the file mapped.
+  auto const* const parse_file_opt =
+      gen_opt.string_ref_ ? "  auto o = opt;\n  o.keep_input_ = true;\n"
+                          : "  auto const& o = opt;\n";
+
+  auto entity_types = std::vector<express::type const*>{};
+  auto entity_names = std::vector<std::string>{};
+  auto n_type_ids = 1U;
   for (auto const& t : schema.types_) {
-    auto header_out = std::ofstream{
-        (header_path / (t.name_ + ".h")).generic_string().c_str()};
-    express::generate_header(header_out, schema, t);
-    express::generate_source(source_out, schema, t);
+    if (t.data_type_ == express::data_type::ENTITY) {
+      entity_types.emplace_back(&t);
+      entity_names.emplace_back(boost::to_upper_copy<std::string>(t.name_));
+      n_type_ids = std::max(n_type_ids, t.type_id_end_);
+    }
   }
+  auto by_type_id = std::vector<express::type const*>(n_type_ids, nullptr);
+  for (auto const* const t : entity_types) {
+    by_type_id[t->type_id_] = t;
+  }
+  auto const entities = step::build_perfect_hash(
+      std::vector<std::string_view>{begin(entity_names), end(entity_names)});
 
   source_out << "\n\n"
                 "#include \""
              << schema.name_ << "/"
              << "parser.h\"\n"
+                "#include \"step/entity_table.h\"\n"
                 "#include \"step/root_entity.h\"\n"
+                "#include \"step/parse_file.h\"\n"
                 "#include \"step/parse_lines.h\"\n"
+                "#include \"step/snapshot.h\"\n"
                 "\n"
              << "namespace " << schema.name_ << "{\n"
              << "\n"
-                "struct full_parser {\n"
-                "  std::optional<step::entity_ptr> parse(\n"
-                "      utl::cstr type_name,\n"
-                "      utl::cstr rest) const {\n"
-                "    switch (cista::hash(type_name.view())) {\n";
-  for (auto const& t : schema.types_) {
-    if (t.data_type_ == express::data_type::ENTITY) {
-      source_out << "      case "
-                 << cista::hash(boost::to_upper_copy<std::string>(t.name_))
-                 << "U: { auto v = std::make_unique<" << t.name_
-                 << ">(); parse_step(rest, *v); return "
-                    "std::unique_ptr<step::root_entity>(v.release()); }\n";
+                "namespace {\n"
+                "\n"
+                "constexpr std::uint32_t const entity_displacements[] = {";
+  for (auto const [i, d] : utl::enumerate(entities.displacements_)) {
+    source_out << (i % 8U == 0U ? "\n    " : " ") << d << "U,";
+  }
+  source_out << "\n};\n"
+                "\n"
+                "constexpr step::entity_table::slot const entity_slots[] = {\n";
+  for (auto const key : entities.slots_) {
+    if (key == step::perfect_hash::kEmpty) {
+      source_out << "    {},\n";
+    } else {
+      source_out << "    {\"" << entity_names[key]
+                 << "\", &step::parse_entity<" << entity_types[key]->name_
+                 << ">},\n";
     }
   }
+  source_out << "};\n"
+                "\n"
+                "// Indexed by type id.\n"
+                "constexpr step::entity_create_fn_t const entity_create[] = {\n";
+  for (auto const* const t : by_type_id) {
+    if (t == nullptr) {
+      source_out << "    nullptr,\n";
+    } else {
+      source_out << "    &step::create_entity<" << t->name_ << ">,\n";
+    }
+  }
+  source_out << "};\n"
+                "\n"
+                "constexpr auto const snapshot_types = step::snapshot_schema{\n"
+                "    SCHEMA_HASH, entity_create, "
+             << by_type_id.size()
+             << "U};\n"
+                "\n"
+                "}  // namespace\n"
+                "\n"
+                "step::entity_table const& entities() {\n"
+                "  static constexpr auto const table = step::entity_table{\n"
+                "      entity_displacements, "
+             << entities.displacements_.size() << "U, entity_slots, "
+             << entities.slots_.size()
+             << "U};\n"
+                "  return table;\n"
+                "}\n"
+                "\n"
+                "step::parse_error full_parser::parse(\n"
+                "    step::arena& mem,\n"
+                "    utl::cstr type_name,\n"
+                "    utl::cstr& rest,\n"
+                "    step::root_entity*& out) const {\n"
+                "  out = nullptr;\n"
+                "  auto const slot = entities().find(type_name.view());\n"
+                "  return slot.has_value()\n"
+                "             ? entity_slots[*slot].parse_(mem, rest, out)\n"
+                "             : step::parse_error::kNone;\n"
+                "}\n"
+                "\n";
   source_out
-      << "      default: return std::nullopt;\n"
-         "    }\n"
-         "  }\n"
-         "};\n"
+      << "step::model parse(step::selective_entity_parser& p, utl::cstr s,\n"
+         "                  step::parse_options const& opt) {\n"
+         "  return step::parse_lines(p, s, opt);\n"
+         "}\n"
          "\n"
          "step::model parse(step::selective_entity_parser& p, utl::cstr s) {\n"
          "  return step::parse_lines(p, s);\n"
          "}\n"
          "\n"
+         "step::model parse(utl::cstr s, step::parse_options const& opt) {\n"
+         "  return step::parse_lines(full_parser{}, s, opt);\n"
+         "}\n"
+         "\n"
          "step::model parse(utl::cstr s) {\n"
          "  return step::parse_lines(full_parser{}, s);\n"
          "}\n"
          "\n"
+         "step::model parse_file(char const* path,\n"
+         "                       step::parse_options const& opt) {\n"
+      << parse_file_opt << "  return step::parse_file(full_parser{}, path, o);\n"
+      << "}\n"
+         "\n"
+         "step::model parse_file(step::selective_entity_parser& p,\n"
+         "                       char const* path,\n"
+         "                       step::parse_options const& opt) {\n"
+      << parse_file_opt << "  return step::parse_file(p, path, o);\n"
+      << "}\n"
+         "\n"
+         "step::lazy_model<full_parser> parse_lazy(\n"
+         "    utl::cstr s, step::parse_options const& opt) {\n"
+         "  return step::lazy_model<full_parser>{full_parser{}, s, opt};\n"
+         "}\n"
+         "\n"
+         "step::lazy_model<full_parser> parse_file_lazy(\n"
+         "    char const* path, step::parse_options const& opt) {\n"
+         "  return step::parse_file_lazy(full_parser{}, path, opt);\n"
+         "}\n"
+         "\n"
+         "void save_snapshot(std::ostream& out, step::model const& m) {\n"
+         "  step::save_snapshot(out, m, SCHEMA_HASH);\n"
+         "}\n"
+         "\n"
+         "step::model load_snapshot(utl::cstr s) {\n"
+         "  return step::load_snapshot(s, snapshot_types);\n"
+         "}\n"
+         "\n"
+         "step::model load_snapshot_file(char const* path) {\n"
+         "  return step::load_snapshot_file(path, snapshot_types);\n"
+         "}\n"
+         "\n"
          "}  // namespace "
       << schema.name_ << "\n";
 
@@ -84,20 +221,120 @@ int main(int argc, char** argv) {
       std::ofstream{(header_path / ("parser.h")).generic_string().c_str()};
   types_header_out
       << "#pragma once\n\n"
+      << "#include <cstdint>\n"
+      << "#include <istream>\n"
+      << "#include <ostream>\n\n"
+      << "#include \"step/arena.h\"\n"
+      << "#include \"step/entity_table.h\"\n"
+      << "#include \"step/for_each_entity.h\"\n"
+      << "#include \"step/lazy_model.h\"\n"
       << "#include \"step/model.h\"\n"
+      << "#include \"step/parse_diagnostics.h\"\n"
+      << "#include \"step/parse_options.h\"\n"
+      << "#include \"step/parse_reachable.h\"\n"
       << "#include \"step/selective_entity_parser.h\"\n\n"
       << "namespace " << schema.name_ << " {\n"
       << "\n"
+      << "struct full_parser {\n"
+         "  // out stays nullptr for unknown types.\n"
+         "  step::parse_error parse(step::arena&, utl::cstr type_name,\n"
+         "                          utl::cstr& rest,\n"
+         "                          step::root_entity*& out) const;\n"
+         "};\n"
+         "\n"
+      << "// Perfect hash table of all entity names.\n"
+         "step::entity_table const& entities();\n"
+         "\n"
+      << "// Hash of all generated types, checked when loading a snapshot.\n"
+         "constexpr auto const SCHEMA_HASH = std::uint64_t{"
+      << schema_hash
+      << "ULL};\n"
+         "\n"
+      << (gen_opt.string_ref_
+              ? "// STRING attributes (step::string_ref) point into the input:\n"
+                "// it has to outlive the returned model.\n"
+              : "")
       << "step::model parse(utl::cstr);\n"
          "\n"
+      << "step::model parse(utl::cstr, step::parse_options const&);\n"
+         "\n"
       << "step::model parse(step::selective_entity_parser&, utl::cstr);\n"
          "\n"
+      << "step::model parse(step::selective_entity_parser&, utl::cstr,\n"
+         "                  step::parse_options const&);\n"
+         "\n"
+      << "step::model parse_file(char const* path,\n"
+         "                       step::parse_options const& = {});\n"
+         "\n"
+      << "step::model parse_file(step::selective_entity_parser&,\n"
+         "                       char const* path,\n"
+         "                       step::parse_options const& = {});\n"
+         "\n"
+      << "// Parses all entities of the root types and everything they reference.\n"
+         "template <typename... Roots>\n"
+         "step::model parse_reachable(utl::cstr s,\n"
+         "                            step::parse_options const& opt = {}) {\n"
+         "  return step::parse_reachable(full_parser{}, s, {Roots::NAME...}, "
+         "opt);\n"
+         "}\n"
+         "\n"
+      << "// Entities are parsed on first access, see step::lazy_model.\n"
+         "step::lazy_model<full_parser> parse_lazy(\n"
+         "    utl::cstr, step::parse_options const& = {});\n"
+         "\n"
+      << "step::lazy_model<full_parser> parse_file_lazy(\n"
+         "    char const* path, step::parse_options const& = {});\n"
+         "\n"
+      << "// Binary snapshot of a parsed model, see step/snapshot.h.\n"
+         "void save_snapshot(std::ostream&, step::model const&);\n"
+         "\n"
+      << "step::model load_snapshot(utl::cstr);\n"
+         "\n"
+      << "step::model load_snapshot_file(char const* path);\n"
+         "\n"
       << "template <typename... Entities>\n"
          "step::model parse(utl::cstr s) {\n"
-         "  step::selective_entity_parser p;\n"
+         "  step::selective_entity_parser p{entities()};\n"
          "  p.register_parsers<Entities...>();\n"
          "  return parse(p, s);\n"
          "}\n"
          "\n"
+      << "template <typename... Entities>\n"
+         "step::model parse(utl::cstr s, step::parse_options const& opt) {\n"
+         "  step::selective_entity_parser p{entities()};\n"
+         "  p.register_parsers<Entities...>();\n"
+         "  return parse(p, s, opt);\n"
+         "}\n"
+         "\n"
+      << "template <typename... Entities>\n"
+         "step::model parse_file(char const* path,\n"
+         "                       step::parse_options const& opt = {}) {\n"
+         "  step::selective_entity_parser p{entities()};\n"
+         "  p.register_parsers<Entities...>();\n"
+         "  return parse_file(p, path, opt);\n"
+         "}\n"
+         "\n"
+      << "template <typename... Entities, typename Fn>\n"
+         "void for_each_entity(utl::cstr s, Fn&& fn) {\n"
+         "  if constexpr (sizeof...(Entities) == 0U) {\n"
+         "    step::for_each_entity(full_parser{}, s, std::forward<Fn>(fn));\n"
+         "  } else {\n"
+         "    step::selective_entity_parser p{entities()};\n"
+         "    p.register_parsers<Entities...>();\n"
+         "    step::for_each_entity(p, s, std::forward<Fn>(fn));\n"
+         "  }\n"
+         "}\n"
+         "\n"
+      << "template <typename... Entities, typename Fn>\n"
+         "void for_each_entity(std::istream& in, Fn&& fn) {\n"
+         "  if constexpr (sizeof...(Entities) == 0U) {\n"
+         "    step::for_each_entity(full_parser{}, in, std::forward<Fn>(fn));\n"
+         "  } else {\n"
+         "    step::selective_entity_parser p{entities()};\n"
+         "    p.register_parsers<Entities...>();\n"
+         "    step::for_each_entity(p, in, std::forward<Fn>(fn));\n"
+         "  }\n"
+         "}\n"
+         "\n"
       << "}  // namespace " << schema.name_;
 }
\ No newline at end of file
@@ -1,12 +1,43 @@
 #pragma once
 
 #include <iosfwd>
+#include <string>
 
 #include "express/parse_exp.h"
 
 namespace express {
 
-void generate_header(std::ostream&, schema const&, type const&);
-void generate_source(std::ostream&, schema const&, type const&);
+struct gen_options {
+  // STRING attributes as step::string_ref pointing into the parser input
+  // instead of std::string copies. The input has to outlive the model.
+  bool string_ref_{false};
 
-}  // namespace express
\ No newline at end of file
+  // STRING attributes as step::interned_string: equal values share one copy
+  // in the model's string pool.
+  bool intern_strings_{false};
+
+  std::string string_type() const {
+    return intern_strings_ ? "step::interned_string"
+           : string_ref_   ? "step::string_ref"
+                           : "std::string";
+  }
+
+  // Header declaring string_type() if it is not std::string.
+  std::string string_header() const {
+    return intern_strings_ ? "step/interned_string.h" : "step/string_ref.h";
+  }
+
+  // Entity references as 4 byte step::ref<T> (id) instead of T*.
+  bool compact_refs_{false};
+
+  std::string ref_type(std::string const& entity) const {
+    return compact_refs_ ? "step::ref<" + entity + ">" : entity + "*";
+  }
+};
+
+void generate_header(std::ostream&, schema const&, type const&,
+                     gen_options const& = {});
+void generate_source(std::ostream&, schema const&, type const&,
+                     gen_options const& = {});
+
+}  // namespace express
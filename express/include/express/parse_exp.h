@@ -66,6 +66,10 @@ struct type {
   bool list_{false};
   unsigned min_size_{0}, max_size_{std::numeric_limits<unsigned>::max()};
   std::string alias_;
+
+  // Entities only: pre-order number in the subtype tree.
+  // Subtypes of this entity have ids in [type_id_, type_id_end_).
+  unsigned type_id_{0U}, type_id_end_{0U};
 };
 
 struct schema {
@@ -76,6 +80,8 @@ struct schema {
 
 schema parse(std::string_view);
 
+void assign_type_ids(schema&);
+
 bool is_list(schema const&, std::string const& type_name);
 
 }  // namespace express
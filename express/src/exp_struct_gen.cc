@@ -1,9 +1,13 @@
 #include "express/exp_struct_gen.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <optional>
 #include <ostream>
+#include <set>
+#include <string>
 
 #include "boost/algorithm/string.hpp"
 
@@ -15,22 +19,23 @@
 namespace express {
 
 static auto const special = std::map<std::string, std::string>{
-    {"BOOLEAN", "bool"},       {"LOGICAL", "step::exp_logical"},
-    {"REAL", "double"},        {"INTEGER", "int"},
-    {"STRING", "std::string"}, {"BINARY(32)", "uint32_t"}};
+    {"BOOLEAN", "bool"}, {"LOGICAL", "step::exp_logical"},
+    {"REAL", "double"},  {"INTEGER", "int"},
+    {"BINARY(32)", "uint32_t"}};
 
 std::optional<std::string> is_special(schema const& s,
-                                      std::string const& type_name) {
+                                      std::string const& type_name,
+                                      gen_options const& opt = {}) {
   if (auto const type_it = s.type_map_.find(type_name);
       type_it != end(s.type_map_)) {
     auto const& t = type_it->second;
     switch (t->data_type_) {
-      case data_type::ALIAS: return is_special(s, t->alias_);
+      case data_type::ALIAS: return is_special(s, t->alias_, opt);
       case data_type::BOOL: [[fallthrough]];
       case data_type::LOGICAL: return "step::exp_logical";
       case data_type::REAL: [[fallthrough]];
       case data_type::NUMBER: return "double";
-      case data_type::STRING: return "std::string";
+      case data_type::STRING: return opt.string_type();
       case data_type::INTEGER: return "int";
       case data_type::ENUM: return type_name;
       case data_type::ENTITY: return std::nullopt;
@@ -39,6 +44,9 @@ std::optional<std::string> is_special(schema const& s,
       case data_type::UNKOWN: throw std::runtime_error{"unkown type"};
     }
   }
+  if (type_name == "STRING") {
+    return opt.string_type();
+  }
   if (auto const special_it = special.find(type_name);
       special_it != end(special)) {
     return special_it->second;
@@ -74,7 +82,29 @@ bool is_value_type(schema const& s, type const& t) {
   }
 }
 
-void generate_header(std::ostream& out, schema const& s, type const& t) {
+// Bounded aggregates up to this size are stored inline (step::inline_vector).
+constexpr auto const kMaxInlineListSize = 4U;
+
+// Maximum size of the list type (following aliases).
+unsigned list_max_size(schema const& s, std::string const& type_name) {
+  auto const& t = *s.type_map_.at(type_name);
+  return t.data_type_ == data_type::ALIAS ? list_max_size(s, t.alias_)
+                                          : t.max_size_;
+}
+
+std::string list_begin(unsigned const max_size) {
+  return max_size <= kMaxInlineListSize ? "step::inline_vector<"
+                                        : "std::vector<";
+}
+
+std::string list_end(unsigned const max_size) {
+  return max_size <= kMaxInlineListSize
+             ? ", " + std::to_string(max_size) + ">"
+             : ">";
+}
+
+void generate_header(std::ostream& out, schema const& s, type const& t,
+                     gen_options const& opt) {
   out << "#pragma once\n\n";
 
   auto const uses_optional =
@@ -86,13 +116,14 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
   auto const uses_string =
       t.data_type_ == data_type::STRING ||
       std::any_of(begin(t.members_), end(t.members_), [&](member const& m) {
-        auto const special = is_special(s, m.get_type_name());
-        return special.has_value() && *special == "std::string";
+        auto const special = is_special(s, m.get_type_name(), opt);
+        return special.has_value() && *special == opt.string_type();
       });
   auto const uses_variant = t.data_type_ == data_type::SELECT;
 
   if (t.subtype_of_.empty()) {
-    out << "#include \"step/root_entity.h\"\n";
+    out << "#include \"step/parse_error.h\"\n"
+        << "#include \"step/root_entity.h\"\n";
   } else {
     out << "#include \"" << s.name_ << "/" << t.subtype_of_ << ".h\"\n";
   }
@@ -100,15 +131,27 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
   if (uses_list || uses_optional || uses_string || uses_variant) {
     out << "\n";
   }
-  out << "#include <iosfwd>\n"
-      << (uses_list ? "#include <vector>\n" : "")
+  out << (uses_list ? "#include <vector>\n" : "")
       << (uses_optional ? "#include <optional>\n" : "")
-      << (uses_string ? "#include <string>\n" : "")
+      << (uses_string && opt.string_type() == "std::string"
+              ? "#include <string>\n"
+              : "")
       << (uses_variant ? "#include <variant>\n" : "")  //
       << "#include <vector>\n";
   if (uses_list || uses_optional || uses_string || uses_variant) {
     out << "\n";
   }
+  if (uses_list || t.list_) {
+    out << "#include \"step/inline_vector.h\"\n\n";
+  }
+  if (uses_string && opt.string_type() != "std::string") {
+    out << "#include \"" << opt.string_header() << "\"\n\n";
+  }
+  if (opt.compact_refs_ && (t.data_type_ == data_type::ENTITY ||
+                            t.data_type_ == data_type::SELECT ||
+                            t.data_type_ == data_type::ALIAS)) {
+    out << "#include \"step/ref.h\"\n\n";
+  }
   if (t.data_type_ == data_type::SELECT) {
     out << "#include \"step/id_t.h\"\n\n";
     for (auto const& d : t.details_) {
@@ -147,7 +190,7 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
     case data_type::INTEGER: out << "using " << t.name_ << " = int;\n"; break;
 
     case data_type::STRING:
-      out << "using " << t.name_ << " = std::string;\n";
+      out << "using " << t.name_ << " = " << opt.string_type() << ";\n";
       break;
 
     case data_type::BINARY:
@@ -161,14 +204,16 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
         }
       }
       out << "\nstruct " << t.name_ << " {\n";
-      out << "  friend void parse_step(utl::cstr&, " << t.name_ << "&);\n";
-      out << "  friend void write(step::write_context const&, std::ostream&, "
-          << t.name_ << " const&);\n";
+      out << "  friend step::parse_error parse_step(utl::cstr&, " << t.name_
+          << "&);\n";
+      out << "  friend void write(step::write_context const&, "
+          << "step::write_buffer&, " << t.name_ << " const&);\n";
       out << "  std::string_view name() const;\n";
-      out << "  void resolve(std::vector<step::root_entity*> const&);\n\n";
+      out << "  void resolve(step::id_index const&);\n\n";
       out << "  std::variant<\n";
       for (auto const& [i, v] : utl::enumerate(t.details_)) {
-        out << "    " << v << (!is_value_type(s, *s.type_map_.at(v)) ? "*" : "")
+        out << "    "
+            << (is_value_type(s, *s.type_map_.at(v)) ? v : opt.ref_type(v))
             << (i != t.details_.size() - 1 ? "," : "") << "\n";
       }
       out << "  > data_;\n";
@@ -179,12 +224,13 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
     case data_type::ALIAS:
       out << "using " << t.name_ << " = ";
       if (t.list_) {
-        out << "std::vector<";
+        out << list_begin(t.max_size_);
       }
-      out << t.alias_
-          << (!is_value_type(s, *s.type_map_.at(t.alias_)) ? "*" : "");
+      out << (is_value_type(s, *s.type_map_.at(t.alias_))
+                  ? t.alias_
+                  : opt.ref_type(t.alias_));
       if (t.list_) {
-        out << ">";
+        out << list_end(t.max_size_);
       }
       out << ";\n";
       break;
@@ -196,9 +242,9 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
             << (i != t.details_.size() - 1 ? "," : "") << "\n";
       }
       out << "};\n";
-      out << "void parse_step(utl::cstr&, " << t.name_ << "&);\n";
-      out << "void write(step::write_context const&, std::ostream&, " << t.name_
-          << " const&);\n";
+      out << "step::parse_error parse_step(utl::cstr&, " << t.name_ << "&);\n";
+      out << "void write(step::write_context const&, step::write_buffer&, "
+          << t.name_ << " const&);\n";
       break;
 
     case data_type::ENTITY: {
@@ -219,54 +265,67 @@ void generate_header(std::ostream& out, schema const& s, type const& t) {
         out << " : public " << t.subtype_of_;
       }
       out << " {\n"
+          << "  using self_t = " << t.name_ << ";\n"
           << "  static constexpr auto const NAME = \""
           << boost::to_upper_copy<std::string>(t.name_) << "\";\n"
+          << "  static constexpr auto const TYPE_ID = step::type_id_t{"
+          << t.type_id_ << "U};\n"
+          << "  static constexpr auto const TYPE_ID_END = step::type_id_t{"
+          << t.type_id_end_ << "U};\n"
+          << "  " << t.name_ << "() { type_id_ = TYPE_ID; }\n"
           << "  std::string_view name() const override { return NAME; }\n"
-          << "  friend void parse_step(utl::cstr&, " << t.name_ << "&);\n"
-          << "  void resolve(std::vector<root_entity*> const&) override;\n"
-             "  void write(step::write_context const&, std::ostream&, bool "
-             "const write_type_name) const "
-             "override;\n";
+          << "  friend step::parse_error parse_step(utl::cstr&, " << t.name_
+          << "&);\n"
+          << "  void resolve(step::id_index const&) override;\n"
+             "  void write(step::write_context const&, step::write_buffer&, "
+             "bool const write_type_name) const override;\n"
+             "  void save_snapshot(step::snapshot_writer&) const override;\n"
+             "  void load_snapshot(step::snapshot_reader&) override;\n";
 
       for (auto const& m : t.members_) {
         auto const is_l = m.is_list(s);
 
         struct visit {
-          visit(schema const& s, std::ostream& o) : s_{s}, out_{o} {}
+          visit(schema const& s, gen_options const& opt, std::ostream& o)
+              : s_{s}, opt_{opt}, out_{o} {}
           void operator()(express::type_name const& t) const {
             auto const l = is_list(s_, t.name_);
+            auto const max_size = l ? list_max_size(s_, t.name_) : 0U;
             if (l) {
-              out_ << "std::vector<";
+              out_ << list_begin(max_size);
             }
-            if (auto const data_type = is_special(s_, t.name_);
+            if (auto const data_type = is_special(s_, t.name_, opt_);
                 data_type.has_value()) {
               out_ << *data_type;
             } else {
-              out_ << t.name_ << "*";
+              out_ << opt_.ref_type(t.name_);
             }
             if (l) {
-              out_ << ">";
+              out_ << list_end(max_size);
             }
           }
           void operator()(express::list const& l) const {
-            out_ << "std::vector<";
+            out_ << list_begin(l.max_);
             boost::apply_visitor(*this, l.m_);
-            out_ << ">";
+            out_ << list_end(l.max_);
           }
           schema const& s_;
+          gen_options const& opt_;
           std::ostream& out_;
         };
 
         out << "  "  //
             << (m.optional_ ? "std::optional<" : "");
 
-        boost::apply_visitor(visit{s, out}, m.type_);
+        boost::apply_visitor(visit{s, opt, out}, m.type_);
 
         auto const data_type = is_special(s, m.get_type_name());
         out << (m.optional_ ? ">" : "")  //
             << " " << m.name_ << "_"
-            << (!data_type.has_value() && !is_l && !m.optional_ ? "{nullptr}"
-                                                                : "")
+            << (!data_type.has_value() && !is_l && !m.optional_ &&
+                        !opt.compact_refs_
+                    ? "{nullptr}"
+                    : "")
             << ";\n";
       }
       out << "};\n";
@@ -286,11 +345,18 @@ void list_select_cases(std::ostream& out, schema const& s,
     // Recursion base case -> output case
     auto const [last_type, last_id] = chain.back();
     chain.resize(chain.size() - 1);
-    out << "    case "
-        << cista::hash(boost::to_upper_copy<std::string>(last_type->name_))
-        << "U"
-        << ": { " << s.name_ << "::" << last_type->name_
-        << " v; parse_step(s, v); e = ";
+    auto const name = boost::to_upper_copy<std::string>(last_type->name_);
+    out << "    case " << cista::hash(name) << "U"
+        << ": {\n"
+        << "      if (name != \"" << name << "\") {\n"
+        << "        return step::parse_error::kUnknownSelect;\n"
+        << "      }\n"
+        << "      " << s.name_ << "::" << last_type->name_ << " v;\n"
+        << "      if (auto const err = parse_step(s, v);\n"
+        << "          err != step::parse_error::kNone) {\n"
+        << "        return err;\n"
+        << "      }\n"
+        << "      e = ";
     for (auto const& [i, entry] : utl::enumerate(chain)) {
       auto const& [el_t, select_index] = entry;
       out << s.name_ << "::" << el_t->name_ << "{"
@@ -318,13 +384,120 @@ void list_select_cases(std::ostream& out, schema const& s,
   }
 }
 
+// Entity alternatives reachable through a SELECT (also through nested
+// SELECTs) in declaration order. Each entry holds the variant index per level.
+struct select_entity {
+  std::vector<std::pair<type const*, std::size_t>> chain_;
+  type const* entity_;
+};
+
+void collect_select_entities(
+    schema const& s, std::vector<std::pair<type const*, std::size_t>>& chain,
+    std::vector<select_entity>& out) {
+  utl::verify(chain.size() < 32U, "select {} nested too deep",
+              chain.front().first->name_);
+  auto const* const select = chain.back().first;
+  for (auto const& [i, m] : utl::enumerate(select->details_)) {
+    auto const* const m_type = s.type_map_.at(m);
+    if (m_type->list_) {
+      continue;
+    }
+    chain.back().second = i;
+    if (m_type->data_type_ == data_type::ENTITY) {
+      out.push_back(select_entity{chain, m_type});
+    } else if (m_type->data_type_ == data_type::SELECT) {
+      chain.emplace_back(m_type, std::numeric_limits<std::size_t>::max());
+      collect_select_entities(s, chain, out);
+      chain.resize(chain.size() - 1U);
+    }
+  }
+}
+
+// Maps entity type ids to select_entity indices (+1, 0 = no match). The first
+// matching alternative wins, subtypes are matched by their supertype.
+std::vector<unsigned> select_dispatch_table(
+    std::vector<select_entity> const& alternatives, unsigned const first,
+    unsigned const last) {
+  auto table = std::vector<unsigned>(last - first, 0U);
+  for (auto const& [i, alt] : utl::enumerate(alternatives)) {
+    for (auto id = alt.entity_->type_id_; id != alt.entity_->type_id_end_;
+         ++id) {
+      if (table[id - first] == 0U) {
+        table[id - first] = static_cast<unsigned>(i + 1U);
+      }
+    }
+  }
+  return table;
+}
+
+void generate_select_resolve(std::ostream& out, schema const& s,
+                             type const& t,
+                             std::vector<select_entity> const& alternatives,
+                             gen_options const& opt) {
+  if (alternatives.empty()) {
+    out << "void " << t.name_ << "::resolve(step::id_index const&) {}\n\n";
+    return;
+  }
+
+  auto first = std::numeric_limits<unsigned>::max(), last = 0U;
+  for (auto const& alt : alternatives) {
+    first = std::min(first, alt.entity_->type_id_);
+    last = std::max(last, alt.entity_->type_id_end_);
+  }
+  auto const table = select_dispatch_table(alternatives, first, last);
+  utl::verify(alternatives.size() <= std::numeric_limits<std::uint8_t>::max(),
+              "select {}: too many entity alternatives", t.name_);
+
+  out << "void " << t.name_ << "::resolve(step::id_index const& m) {\n";
+  out << "  if (tmp_id_ == step::id_t::invalid()) { return; }\n";
+  out << "  auto* const e = m.find(tmp_id_);\n";
+  out << "  if (e == nullptr) { return; }\n";
+  out << "  // type id - " << first << " -> entity alternative\n";
+  out << "  static constexpr std::uint8_t const alternative[] = {";
+  for (auto const& [i, x] : utl::enumerate(table)) {
+    out << (i % 16U == 0U ? "\n    " : " ") << x << "U,";
+  }
+  out << "\n  };\n";
+  out << "  auto const idx = e->type_id_ - " << first << "U;\n";
+  out << "  switch (idx < " << table.size()
+      << "U ? alternative[idx] : 0U) {\n";
+  for (auto const& [i, alt] : utl::enumerate(alternatives)) {
+    out << "    case " << (i + 1U) << "U: ";
+    auto target = std::string{"data_"};
+    for (auto const& [level, entry] : utl::enumerate(alt.chain_)) {
+      auto const select_index = entry.second;
+      if (level + 1U == alt.chain_.size()) {
+        if (opt.compact_refs_) {
+          out << target << ".emplace<" << select_index << ">(step::ref<"
+              << s.name_ << "::" << alt.entity_->name_ << ">{tmp_id_});";
+        } else {
+          out << target << ".emplace<" << select_index << ">(static_cast<"
+              << s.name_ << "::" << alt.entity_->name_ << "*>(e));";
+        }
+      } else {
+        out << "{ auto& v" << level << " = " << target << ".emplace<"
+            << select_index << ">(); ";
+        target = "v" + std::to_string(level) + ".data_";
+      }
+    }
+    for (auto level = 1U; level < alt.chain_.size(); ++level) {
+      out << " }";
+    }
+    out << " break;\n";
+  }
+  out << "    default: break;\n";
+  out << "  }\n";
+  out << "}\n\n";
+}
+
 bool has_members(schema const& s, type const& t) {
   return !t.members_.empty() ||
          (!t.subtype_of_.empty() &&
           has_members(s, *s.type_map_.at(t.subtype_of_)));
 };
 
-void generate_source(std::ostream& out, schema const& s, type const& t) {
+void generate_source(std::ostream& out, schema const& s, type const& t,
+                     gen_options const& opt) {
   switch (t.data_type_) {
     case data_type::SELECT: {
       out << "#include \"" << s.name_ << "/" << t.name_ << ".h\"\n\n"
@@ -332,14 +505,26 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
           << "#include \"utl/verify.h\"\n\n"
           << "#include \"step/parse_step.h\"\n"
           << "#include \"step/write.h\"\n"
-          << "#include \"step/assign_entity_ptr_to_select.h\"\n"
-          << "#include \"step/resolve.h\"\n\n"
-          << "namespace " << s.name_ << " {\n\n";
-      out << "void parse_step(utl::cstr& s, " << t.name_ << "& e) {\n";
+          << "#include \"step/resolve.h\"\n\n";
+
+      auto alternatives = std::vector<select_entity>{};
+      auto chain = std::vector<std::pair<type const*, std::size_t>>{
+          {&t, std::numeric_limits<std::size_t>::max()}};
+      collect_select_entities(s, chain, alternatives);
+      auto included = std::set<type const*>{};
+      for (auto const& alt : alternatives) {
+        if (included.emplace(alt.entity_).second) {
+          out << "#include \"" << s.name_ << "/" << alt.entity_->name_
+              << ".h\"\n";
+        }
+      }
+
+      out << "\nnamespace " << s.name_ << " {\n\n";
+      out << "step::parse_error parse_step(utl::cstr& s, " << t.name_
+          << "& e) {\n";
       out << "  using step::parse_step;\n";
       out << "  if (s.len != 0 && s[0] == '#') {\n";
-      out << "    parse_step(s, e.tmp_id_);\n";
-      out << "    return;\n";
+      out << "    return parse_step(s, e.tmp_id_);\n";
       out << "  }\n";
 
       auto const select_has_value_types = std::any_of(
@@ -348,32 +533,28 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
           });
       if (select_has_value_types) {
         out << "  auto const name_end = step::get_next_token(s, '(');\n";
-        out << R"(  utl::verify(name_end.has_value(), "expected SELECT name, got {}", s.view());)"
-            << "\n";
+        out << "  if (!name_end.has_value()) {\n"
+            << "    return step::parse_error::kExpectedSelect;\n"
+            << "  }\n";
         out << R"(  auto const name = std::string_view{s.str, static_cast<std::size_t>(name_end->str - s.str - 1)};)"
             << "\n";
         out << "  s = *name_end;\n";
         out << "  switch(cista::hash(name)) {\n";
         list_select_cases(out, s,
                           {{&t, std::numeric_limits<std::size_t>::max()}});
-        out << "    default: utl::verify(false, \"unable to parse select "
-            << s.name_ << "::" << t.name_
-            << ", got name '{}', hash={}\", name, cista::hash(name));\n";
+        out << "    default: return step::parse_error::kUnknownSelect;\n";
         out << "  }\n";
-        out << R"(  utl::verify(s.len != 0 && s[0] == ')', "expected select end ')', got {}", s.view());)"
-            << "\n";
+        out << "  if (s.len == 0 || s[0] != ')') {\n"
+            << "    return step::parse_error::kExpectedSelect;\n"
+            << "  }\n";
         out << "  ++s;\n";
+        out << "  return step::parse_error::kNone;\n";
       } else {
-        out << "  utl::verify(false, \"select: expected id, got {}\", "
-               "s.view());\n";
+        out << "  return step::parse_error::kExpectedId;\n";
       }
 
       out << "}\n\n";
-      out << "void " << t.name_
-          << "::resolve(std::vector<step::root_entity*> const& m) {\n";
-      out << "  if (tmp_id_ == step::id_t::invalid()) { return; }\n";
-      out << "  step::assign_entity_ptr_to_select(*this, m.at(tmp_id_.id_));\n";
-      out << "}\n\n";
+      generate_select_resolve(out, s, t, alternatives, opt);
 
       out << "std::string_view " << t.name_ << "::name() const {\n";
       out << "  static char const* names[] = {\n";
@@ -389,13 +570,15 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
       out << "  return names[data_.index()];\n"
              "}\n\n";
 
-      out << "void write(step::write_context const& ctx, std::ostream& out, "
+      out << "void write(step::write_context const& ctx, "
+             "step::write_buffer& out, "
           << t.name_ << " const& el) {\n";
       out << "  std::visit([&](auto&& data) {\n"
              "    using step::write;\n"
              "    using Type = std::decay_t<decltype(data)>\n;"
              "    constexpr auto const final = "
-             "!step::has_data<Type>::value && !std::is_pointer_v<Type>;\n"
+             "!step::has_data<Type>::value && !std::is_pointer_v<Type> &&\n"
+             "        !step::is_ref<Type>::value;\n"
              "    if constexpr (final) {\n"
              "      out << el.name() << '(';\n"
              "    }\n"
@@ -413,27 +596,36 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
           << "#include \"utl/parser/cstr.h\"\n\n"
           << "#include \"step/parse_step.h\"\n"
           << "#include \"step/resolve.h\"\n"
+          << "#include \"step/snapshot.h\"\n"
           << "#include \"step/write.h\"\n\n"
           << "namespace " << s.name_ << " {\n\n";
-      out << "void parse_step(utl::cstr& s, " << t.name_ << "& e) {\n";
+      out << "step::parse_error parse_step(utl::cstr& s, " << t.name_
+          << "& e) {\n";
       out << "  using step::parse_step;\n";
       if (!t.subtype_of_.empty()) {
-        out << "  parse_step(s, *static_cast<" << t.subtype_of_ << "*>(&e));\n";
+        out << "  if (auto const err = parse_step(s, *static_cast<"
+            << t.subtype_of_ << "*>(&e));\n"
+            << "      err != step::parse_error::kNone) {\n"
+            << "    return err;\n"
+            << "  }\n";
       }
       for (auto const& m : t.members_) {
         out << "  if (s.len > 0 && s[0] == '*') {\n"
             << "    ++s;\n"
-            << "  } else {\n"
-            << "    parse_step(s, e." << m.name_ << "_);\n"
+            << "  } else if (auto const err = parse_step(s, e." << m.name_
+            << "_);\n"
+            << "             err != step::parse_error::kNone) {\n"
+            << "    return err;\n"
             << "  }\n"
             << "  if (s.len > 0 && s[0] == ',') {\n"
             << "    ++s;\n"
             << "  }\n"
             << "  s = s.skip_whitespace_front();\n\n";
       }
+      out << "  return step::parse_error::kNone;\n";
       out << "}\n\n";
       out << "void " << t.name_
-          << "::resolve(std::vector<root_entity*> const& m) {\n";
+          << "::resolve(step::id_index const& m) {\n";
       if (!t.subtype_of_.empty()) {
         out << "  " << t.subtype_of_ << "::resolve(m);\n";
       }
@@ -448,9 +640,8 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
       out << "}\n";
 
       out << "void " << t.name_
-          << "::write(step::write_context const& ctx, std::ostream& out, bool "
-             "const write_type_name) const "
-             "{\n"
+          << "::write(step::write_context const& ctx, step::write_buffer& out, "
+             "bool const write_type_name) const {\n"
              "  using step::write;\n"
              "  if (write_type_name) { out << \""
           << boost::to_upper_copy<std::string>(t.name_) << "(\"; }\n";
@@ -473,6 +664,26 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
       out << "  if (write_type_name) { out << \");\"; }\n";
       out << "}\n";
 
+      out << "void " << t.name_
+          << "::save_snapshot(step::snapshot_writer& w) const {\n";
+      if (!t.subtype_of_.empty()) {
+        out << "  " << t.subtype_of_ << "::save_snapshot(w);\n";
+      }
+      for (auto const& m : t.members_) {
+        out << "  step::save(w, " << m.name_ << "_);\n";
+      }
+      out << "}\n";
+
+      out << "void " << t.name_
+          << "::load_snapshot(step::snapshot_reader& r) {\n";
+      if (!t.subtype_of_.empty()) {
+        out << "  " << t.subtype_of_ << "::load_snapshot(r);\n";
+      }
+      for (auto const& m : t.members_) {
+        out << "  step::load(r, " << m.name_ << "_);\n";
+      }
+      out << "}\n";
+
       out << "\n}  // namespace " << s.name_ << "\n\n\n";
 
       break;
@@ -482,28 +693,35 @@ void generate_source(std::ostream& out, schema const& s, type const& t) {
       out << "#include \"utl/parser/cstr.h\"\n";
       out << "#include \"utl/verify.h\"\n\n";
       out << "#include \"cista/hash.h\"\n\n";
-      out << "#include \"step/parse_step.h\"\n\n";
+      out << "#include \"step/parse_step.h\"\n";
+      out << "#include \"step/write_buffer.h\"\n\n";
       out << "namespace " << s.name_ << " {\n\n";
-      out << "void parse_step(utl::cstr& s, " << t.name_ << "& v) {\n";
-      out << "  utl::verify(s.len != 0 && s[0] == '.', \"expected enum start "
-             "'.', got {}\", s.view());\n";
-      out << "  ++s;\n";
-      out << "  auto const end = step::get_next_token(s, '.');\n";
-      out << "  utl::verify(end.has_value(), \"enum end not found, got {}\", "
-             "s.view());\n";
-      out << "  auto const str = std::string_view{s.str, "
-             "static_cast<unsigned>(end->str - s.str - 1)};\n";
+      out << "step::parse_error parse_step(utl::cstr& s, " << t.name_
+          << "& v) {\n";
+      out << "  if (s.len == 0 || s[0] != '.') {\n"
+          << "    return step::parse_error::kExpectedEnum;\n"
+          << "  }\n";
+      out << "  auto const end = step::get_next_token(s.substr(1), '.');\n";
+      out << "  if (!end.has_value()) {\n"
+          << "    return step::parse_error::kExpectedEnum;\n"
+          << "  }\n";
+      out << "  auto const str = std::string_view{s.str + 1, "
+             "static_cast<unsigned>(end->str - s.str - 2)};\n";
       out << "  switch(cista::hash(str)) {\n";
       for (auto const& [i, m] : utl::enumerate(t.details_)) {
-        out << "    case " << cista::hash(m) << "U: v = " << t.name_
-            << "::" << s.name_ << "_" << m << "; break;\n";
+        out << "    case " << cista::hash(m) << "U:\n"
+            << "      if (str != \"" << m << "\") {\n"
+            << "        return step::parse_error::kUnknownEnumValue;\n"
+            << "      }\n"
+            << "      v = " << t.name_ << "::" << s.name_ << "_" << m
+            << "; break;\n";
       }
-      out << "    default: utl::verify(false, \"expected enum value, got {}\", "
-             "str);\n";
+      out << "    default: return step::parse_error::kUnknownEnumValue;\n";
       out << "  }\n";
       out << "  s = *end;\n";
+      out << "  return step::parse_error::kNone;\n";
       out << "}\n\n";
-      out << "void write(step::write_context const&, std::ostream& out, "
+      out << "void write(step::write_context const&, step::write_buffer& out, "
           << t.name_ << " const& val) {\n"
           << "  switch (val) {\n";
       for (auto const& [i, m] : utl::enumerate(t.details_)) {
@@ -224,7 +224,39 @@ schema parse(std::string_view s) {
   for (auto const& t : schema.types_) {
     schema.type_map_[t.name_] = &t;
   }
+  assign_type_ids(schema);
   return schema;
 }
 
+void assign_type_ids(schema& s) {
+  std::vector<type*> roots;
+  std::unordered_map<std::string_view, std::vector<type*>> subtypes;
+  for (auto& t : s.types_) {
+    if (t.data_type_ != data_type::ENTITY) {
+      continue;
+    }
+    if (t.subtype_of_.empty() ||
+        s.type_map_.find(t.subtype_of_) == end(s.type_map_)) {
+      roots.emplace_back(&t);
+    } else {
+      subtypes[t.subtype_of_].emplace_back(&t);
+    }
+  }
+
+  // 0 = no type id
+  auto next_id = 1U;
+  auto const assign = [&](type& t, auto&& self) -> void {
+    t.type_id_ = next_id++;
+    if (auto const it = subtypes.find(t.name_); it != end(subtypes)) {
+      for (auto* const subtype : it->second) {
+        self(*subtype, self);
+      }
+    }
+    t.type_id_end_ = next_id;
+  };
+  for (auto* const root : roots) {
+    assign(*root, assign);
+  }
+}
+
 }  // namespace express
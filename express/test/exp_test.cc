@@ -334,6 +334,36 @@ TEST_CASE("parse ifc schema") {
   CHECK(get_subtypes_of(schema, "IfcProduct").size() == 90);
 }
 
+TEST_CASE("entity type ids") {
+  boost::filesystem::current_path(TEST_EXECUTION_DIR);
+  auto const f =
+      cista::mmap{"express/test/ifc23.txt", cista::mmap::protection::READ};
+  auto const schema = parse(
+      std::string_view{reinterpret_cast<char const*>(f.data()), f.size()});
+
+  std::set<unsigned> ids;
+  for (auto const& t : schema.types_) {
+    if (t.data_type_ != data_type::ENTITY) {
+      CHECK(t.type_id_ == 0U);
+      continue;
+    }
+
+    CHECK(t.type_id_ != 0U);
+    CHECK(ids.emplace(t.type_id_).second);
+
+    // Pre-order numbering: exactly the subtypes are in [id, end).
+    auto const subtypes = get_subtypes_of(schema, t.name_);
+    CHECK(t.type_id_end_ - t.type_id_ == subtypes.size());
+    for (auto const& subtype_name : subtypes) {
+      auto const& subtype = *schema.type_map_.at(std::string{subtype_name});
+      CHECK(subtype.type_id_ >= t.type_id_);
+      CHECK(subtype.type_id_ < t.type_id_end_);
+    }
+  }
+  CHECK(*ids.begin() == 1U);
+  CHECK(*ids.rbegin() == ids.size());
+}
+
 TEST_CASE("alias to SET") {
   constexpr auto const* exp_input = R"(
 SCHEMA IFC2X3;
@@ -440,6 +470,12 @@ END_SCHEMA)";
   for (auto const& t : schema.types_) {
     CHECK_NOTHROW(generate_header(ss, schema, t));
   }
+
+  // Small bounded lists are stored inline, unbounded ones in std::vector.
+  CHECK(ss.str().find("step::inline_vector<double, 3> Coordinates_;") !=
+        std::string::npos);
+  CHECK(ss.str().find("std::vector<std::vector<IfcCartesianPoint*>> "
+                      "ControlPointsList_;") != std::string::npos);
 }
 
 TEST_CASE("alias vector member") {
@@ -475,3 +511,95 @@ END_SCHEMA
     CHECK_NOTHROW(generate_header(ss, schema, t));
   }
 }
+
+TEST_CASE("string type options") {
+  constexpr auto const* exp_input = R"(
+SCHEMA IFC2X3;
+
+TYPE IfcLabel = STRING;
+END_TYPE;
+
+ENTITY IfcRoot;
+	GlobalId : STRING;
+	Name : OPTIONAL IfcLabel;
+END_ENTITY;
+
+END_SCHEMA
+)";
+
+  auto const schema = parse(exp_input);
+  auto const generate = [&](std::string const& name, gen_options const& opt) {
+    std::stringstream ss;
+    generate_header(ss, schema, *schema.type_map_.at(name), opt);
+    return ss.str();
+  };
+
+  auto const label = generate("IfcLabel", gen_options{true});
+  CHECK(label.find("using IfcLabel = step::string_ref;") != std::string::npos);
+  CHECK(label.find("#include \"step/string_ref.h\"") != std::string::npos);
+
+  auto const root = generate("IfcRoot", gen_options{true});
+  CHECK(root.find("step::string_ref GlobalId_;") != std::string::npos);
+  CHECK(root.find("std::optional<step::string_ref> Name_;") !=
+        std::string::npos);
+  CHECK(root.find("#include <string>") == std::string::npos);
+
+  auto const interned = generate("IfcRoot", gen_options{false, true});
+  CHECK(interned.find("step::interned_string GlobalId_;") != std::string::npos);
+  CHECK(interned.find("#include \"step/interned_string.h\"") !=
+        std::string::npos);
+
+  auto const root_default = generate("IfcRoot", gen_options{});
+  CHECK(root_default.find("std::string GlobalId_;") != std::string::npos);
+  CHECK(root_default.find("std::optional<std::string> Name_;") !=
+        std::string::npos);
+}
+
+TEST_CASE("compact references option") {
+  constexpr auto const* exp_input = R"(
+SCHEMA IFC2X3;
+
+ENTITY IfcPoint;
+	X : REAL;
+END_ENTITY;
+
+ENTITY IfcLoop;
+	Points : LIST [3:?] OF IfcPoint;
+	Start : IfcPoint;
+END_ENTITY;
+
+TYPE IfcShapeSelect = SELECT
+	(IfcPoint
+	,IfcLoop);
+END_TYPE;
+
+END_SCHEMA
+)";
+
+  auto const schema = parse(exp_input);
+  auto const opt = gen_options{false, false, true};
+  auto const generate = [&](std::string const& name, bool const source) {
+    std::stringstream ss;
+    if (source) {
+      generate_source(ss, schema, *schema.type_map_.at(name), opt);
+    } else {
+      generate_header(ss, schema, *schema.type_map_.at(name), opt);
+    }
+    return ss.str();
+  };
+
+  auto const loop = generate("IfcLoop", false);
+  CHECK(loop.find("#include \"step/ref.h\"") != std::string::npos);
+  CHECK(loop.find("std::vector<step::ref<IfcPoint>> Points_;") !=
+        std::string::npos);
+  CHECK(loop.find("step::ref<IfcPoint> Start_;") != std::string::npos);
+
+  auto const select = generate("IfcShapeSelect", false);
+  CHECK(select.find("step::ref<IfcPoint>,") != std::string::npos);
+  CHECK(select.find("step::ref<IfcLoop>\n") != std::string::npos);
+
+  auto const resolve = generate("IfcShapeSelect", true);
+  CHECK(resolve.find("emplace<0>(step::ref<IFC2X3::IfcPoint>{tmp_id_})") !=
+        std::string::npos);
+  CHECK(resolve.find("static_cast<IFC2X3::") == std::string::npos);
+}
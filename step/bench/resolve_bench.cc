@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "step/model.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_lines.h"
+#include "step/parse_records.h"
+#include "step/resolve_entities.h"
+#include "step/thread_count.h"
+
+#include "IFC2X3/parser.h"
+
+// Times resolve_entities on a generated model (points referenced in random
+// order by poly loops) for different thread counts.
+//   step-bench [number of entities, default 1M] [repetitions, default 5]
+
+namespace {
+
+std::string generate_input(unsigned const n_entities) {
+  auto const n_points = n_entities - n_entities / 4U;
+  auto rng = std::mt19937{42U};
+  auto point = std::uniform_int_distribution<unsigned>{1U, n_points};
+
+  auto input = std::string{};
+  for (auto i = 1U; i <= n_points; ++i) {
+    input += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+             std::to_string(i) + ".,0.,0.));\n";
+  }
+  for (auto i = n_points + 1U; i <= n_entities; ++i) {
+    input += "#" + std::to_string(i) + "=IFCPOLYLOOP((#" +
+             std::to_string(point(rng)) + ",#" + std::to_string(point(rng)) +
+             ",#" + std::to_string(point(rng)) + "));\n";
+  }
+  return input;
+}
+
+step::model parse_unresolved(utl::cstr const input) {
+  auto m = step::model{};
+  auto diag = step::parse_diagnostics{};
+  step::detail::parse_records(
+      IFC2X3::full_parser{}, m.arena_, m.strings_, input,
+      [&](step::root_entity* e) { step::detail::add_parsed_entity(m, e); },
+      diag);
+  step::detail::print_parse_errors(diag);
+  return m;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto const n_entities = argc > 1
+                              ? static_cast<unsigned>(std::atoi(argv[1]))
+                              : 1'000'000U;
+  auto const repetitions =
+      argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 5U;
+  auto const input = generate_input(n_entities);
+
+  auto serial_ms = 0.0;
+  for (auto const threads : {1U, 2U, 4U, 8U, 0U}) {
+    auto best_ms = 0.0;
+    for (auto r = 0U; r != repetitions; ++r) {
+      auto m = parse_unresolved(input);
+      auto const start = std::chrono::steady_clock::now();
+      step::resolve_entities(m, threads);
+      auto const ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+      best_ms = r == 0U ? ms : std::min(best_ms, ms);
+    }
+    if (threads == 1U) {
+      serial_ms = best_ms;
+    }
+    std::printf("threads=%u  entities=%u  resolve=%.2fms  speedup=%.2fx\n",
+                step::thread_count(threads), n_entities, best_ms,
+                serial_ms / best_ms);
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace step {
+
+namespace detail {
+
+std::size_t next_slab_idx();
+
+template <typename T>
+std::size_t slab_idx() {
+  static auto const idx = next_slab_idx();
+  return idx;
+}
+
+}  // namespace detail
+
+// Monotonic allocator with one slab per type: objects of the same type are
+// placed next to each other in large blocks. Objects are destroyed and their
+// memory is released (block by block) when the arena is destroyed.
+struct arena {
+  struct block {
+    unsigned char* mem_{nullptr};
+    std::size_t used_{0U};
+  };
+
+  struct slab {
+    std::size_t obj_size_{0U}, objs_per_block_{0U};
+    void (*destroy_)(void*){nullptr};
+    std::vector<block> blocks_;  // [0, current_]: in use, rest: empty
+    std::size_t current_{0U};
+    bool used_{false};
+  };
+
+  arena() = default;
+  arena(arena const&) = delete;
+  arena(arena&&) noexcept;
+  arena& operator=(arena const&) = delete;
+  arena& operator=(arena&&) noexcept;
+  ~arena();
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+    auto& s = get_slab(detail::slab_idx<T>(), sizeof(T),
+                       [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+    auto* const mem = allocate(s);
+    auto* const obj = new (mem) T(std::forward<Args>(args)...);
+    ++s.blocks_[s.current_].used_;
+    return obj;
+  }
+
+  // Unaligned storage for variable length data (e.g. unescaped strings).
+  // Released by clear() and when the arena is destroyed.
+  char* allocate_bytes(std::size_t);
+
+  // Takes over all objects of the other arena. O(number of blocks).
+  void merge(arena&&);
+
+  // Destroys all objects. Allocated object blocks are kept for reuse.
+  void clear();
+
+  std::size_t size() const;
+
+  slab& get_slab(std::size_t idx, std::size_t obj_size,
+                 void (*destroy)(void*));
+  void* allocate(slab&);
+  void destroy();
+
+  std::vector<slab> slabs_;
+  std::vector<std::size_t> used_slabs_;
+  std::vector<block> bytes_;  // back() is the one currently filled
+};
+
+}  // namespace step
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <type_traits>
+
+#include "step/root_entity.h"
+
+namespace step {
+
+// True for generated entities only: a user subclass inherits TYPE_ID and
+// self_t, but self_t does not name the subclass.
+template <typename T, typename = void>
+struct has_type_id : std::false_type {};
+
+template <typename T>
+struct has_type_id<T, std::void_t<decltype(T::TYPE_ID), typename T::self_t>>
+    : std::is_same<typename T::self_t, T> {};
+
+// Checked downcast. Generated entities are checked by type id range
+// (no RTTI), other root_entity subclasses fall back to dynamic_cast.
+// Type ids are numbered per schema: the schema of e is not checked, so
+// e has to come from a model of the schema that T belongs to.
+template <typename T>
+T* entity_cast(root_entity* e) {
+  if constexpr (has_type_id<T>::value) {
+    return (e != nullptr && e->is_a<T>()) ? static_cast<T*>(e) : nullptr;
+  } else {
+    return dynamic_cast<T*>(e);
+  }
+}
+
+template <typename T>
+T const* entity_cast(root_entity const* e) {
+  return entity_cast<T>(const_cast<root_entity*>(e));  // NOLINT
+}
+
+}  // namespace step
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "cista/hash.h"
+
+#include "utl/parser/cstr.h"
+
+#include "step/arena.h"
+#include "step/parse_error.h"
+#include "step/perfect_hash.h"
+#include "step/root_entity.h"
+
+namespace step {
+
+// Stores the created entity in out, also if parsing fails. On error, s
+// points to the position of the error.
+using entity_parse_fn_t = parse_error (*)(arena&, utl::cstr& s,
+                                          root_entity*& out);
+
+template <typename T>
+parse_error parse_entity(arena& mem, utl::cstr& s, root_entity*& out) {
+  auto* const v = mem.create<T>();
+  out = v;
+  return parse_step(s, *v);
+}
+
+// Generated per schema: perfect hash table of all entity names.
+struct entity_table {
+  struct slot {
+    std::string_view name_;
+    entity_parse_fn_t parse_{nullptr};  // nullptr: empty slot
+  };
+
+  // The name is compared, a hash collision can not return the wrong slot.
+  std::optional<std::size_t> find(std::string_view const name) const {
+    auto const i = perfect_hash_slot(cista::hash(name), displacements_,
+                                     n_displacements_, n_slots_);
+    if (slots_[i].parse_ != nullptr && slots_[i].name_ == name) {
+      return i;
+    }
+    return std::nullopt;
+  }
+
+  std::uint32_t const* displacements_;
+  std::size_t n_displacements_;
+  slot const* slots_;
+  std::size_t n_slots_;
+};
+
+}  // namespace step
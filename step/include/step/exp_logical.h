@@ -1,11 +1,15 @@
 #pragma once
 
 #include <iosfwd>
+#include <string_view>
 
 namespace step {
 
 enum class exp_logical { EXP_TRUE, EXP_FALSE, EXP_UNKNOWN };
 
+// ".T.", ".F." or ".U."
+std::string_view to_str(exp_logical);
+
 std::ostream& operator<<(std::ostream&, exp_logical);
 
 }  // namespace step
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <vector>
+
+#include "utl/parser/cstr.h"
+
+#include "step/arena.h"
+#include "step/id_t.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_records.h"
+#include "step/ref.h"
+#include "step/root_entity.h"
+#include "step/string_pool.h"
+
+namespace step {
+
+// Entities passed to for_each_entity are not resolved:
+// entity pointer members still hold the referenced id.
+template <typename T>
+id_t unresolved_id(T const* ptr) {
+  return id_t{static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(ptr))};
+}
+
+template <typename T>
+id_t unresolved_id(ref<T> const r) {
+  return r.id_;
+}
+
+// Calls fn(root_entity&) for each entity in the input.
+// Entities are destroyed after the callback returns. Interned strings stay
+// valid until the end of the pass (the input is in memory anyway).
+// Errors are printed unless a diagnostics sink is given.
+template <typename Parser, typename Fn>
+void for_each_entity(Parser const& p, utl::cstr step, Fn&& fn,
+                     parse_diagnostics* diagnostics = nullptr) {
+  arena mem;
+  string_pool strings;
+  auto printed = parse_diagnostics{};
+  detail::parse_records(
+      p, mem, strings, step,
+      [&](root_entity* e) {
+        fn(*e);
+        mem.clear();
+      },
+      diagnostics == nullptr ? printed : *diagnostics);
+  detail::print_parse_errors(printed);
+}
+
+// Reads the input block by block. Memory usage is bounded by the
+// block size (or the longest record, whichever is larger).
+// Interned strings are only valid until the callback returns.
+template <typename Parser, typename Fn>
+void for_each_entity(Parser const& p, std::istream& in, Fn&& fn,
+                     std::size_t const block_size = 1024U * 1024U,
+                     parse_diagnostics* diagnostics = nullptr) {
+  auto buf = std::vector<char>(std::max(block_size, std::size_t{1U}));
+  auto filled = std::size_t{0U};
+  auto line_offset = std::size_t{0U};
+  auto byte_offset = std::size_t{0U};
+  auto eof = false;
+  arena mem;
+  string_pool strings;  // cleared after each block
+  auto printed = parse_diagnostics{};
+  auto& diag = diagnostics == nullptr ? printed : *diagnostics;
+  auto block_diag = parse_diagnostics{diag.policy_};
+  while (!eof && !diag.aborted_) {
+    if (filled == buf.size()) {
+      buf.resize(buf.size() * 2U);  // record does not fit into the buffer
+    }
+    in.read(buf.data() + filled,
+            static_cast<std::streamsize>(buf.size() - filled));
+    filled += static_cast<std::size_t>(in.gcount());
+    eof = !in;
+
+    // Only complete records are parsed, the rest is kept for the next block.
+    block_diag.n_errors_ = 0U;
+    block_diag.errors_.clear();
+    auto const rest = detail::parse_records(
+        p, mem, strings, utl::cstr{buf.data(), filled},
+        [&](root_entity* e) {
+          e->source_offset_ += byte_offset;
+          fn(*e);
+          mem.clear();
+        },
+        block_diag, eof);
+    diag.append(block_diag, line_offset, byte_offset);
+    line_offset += rest.line_idx_;
+    strings.clear();
+
+    auto const consumed = static_cast<std::size_t>(rest.str_.str - buf.data());
+    std::memmove(buf.data(), rest.str_.str, rest.str_.len);
+    filled -= consumed;
+    byte_offset += consumed;
+  }
+  detail::print_parse_errors(printed);
+}
+
+}  // namespace step
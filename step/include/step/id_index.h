@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "step/id_t.h"
+
+namespace step {
+
+struct root_entity;
+
+// Maps entity ids to entities.
+//
+// Ids are split into a page number and an offset into the page. Pages are
+// only allocated for id ranges that contain entities, so memory grows with
+// the number of entities instead of the largest id. Ids that would require
+// a page directory larger than the number of entities (e.g. a single
+// outlier id) are stored in a hash map until enough entities are inserted.
+struct id_index {
+  static constexpr auto const kPageBits = 10U;
+  static constexpr auto const kPageSize = 1U << kPageBits;
+  static constexpr auto const kMinDirectorySize = std::size_t{1024U};
+
+  using page = std::array<root_entity*, kPageSize>;
+
+  root_entity* find(id_t const id) const {
+    auto const page_idx = id.id_ >> kPageBits;
+    if (page_idx < directory_.size()) {
+      auto const& p = directory_[page_idx];
+      return p == nullptr ? nullptr : (*p)[id.id_ & (kPageSize - 1U)];
+    } else if (!overflow_.empty()) {
+      auto const it = overflow_.find(id.id_);
+      return it == end(overflow_) ? nullptr : it->second;
+    } else {
+      return nullptr;
+    }
+  }
+
+  root_entity* operator[](id_t const id) const { return find(id); }
+
+  void insert(id_t, root_entity*);
+  root_entity*& slot(unsigned id);
+
+  // Number of ids with an entity.
+  std::size_t size() const { return size_; }
+
+  // Smallest id larger than all ids in the index.
+  id_t next_id() const { return next_id_; }
+
+  std::vector<std::unique_ptr<page>> directory_;
+  std::unordered_map<unsigned, root_entity*> overflow_;
+  std::size_t size_{0U};
+  id_t next_id_{0U};
+};
+
+}  // namespace step
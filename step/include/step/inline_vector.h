@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "utl/verify.h"
+
+namespace step {
+
+// std::vector-like container with inline storage for at most N elements.
+// Generated for small bounded aggregates (e.g. LIST [1:3] OF REAL).
+template <typename T, std::size_t N>
+struct inline_vector {
+  static_assert(N != 0U && N <= 255U);
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = T const*;
+
+  inline_vector() = default;
+  inline_vector(std::initializer_list<T> init) { assign(init); }
+
+  inline_vector& operator=(std::initializer_list<T> init) {
+    assign(init);
+    return *this;
+  }
+
+  void assign(std::initializer_list<T> init) {
+    utl::verify(init.size() <= N, "inline_vector: {} elements, capacity {}",
+                init.size(), N);
+    std::copy(init.begin(), init.end(), begin());
+    size_ = static_cast<std::uint8_t>(init.size());
+  }
+
+  static constexpr size_type capacity() { return N; }
+  static constexpr size_type max_size() { return N; }
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0U; }
+
+  T* data() { return mem_.data(); }
+  T const* data() const { return mem_.data(); }
+  iterator begin() { return mem_.data(); }
+  iterator end() { return mem_.data() + size_; }
+  const_iterator begin() const { return mem_.data(); }
+  const_iterator end() const { return mem_.data() + size_; }
+
+  T& operator[](size_type const i) { return mem_[i]; }
+  T const& operator[](size_type const i) const { return mem_[i]; }
+  T& at(size_type const i) {
+    utl::verify(i < size_, "inline_vector: index {} >= size {}", i, size_);
+    return mem_[i];
+  }
+  T const& at(size_type const i) const {
+    return const_cast<inline_vector*>(this)->at(i);  // NOLINT
+  }
+  T& front() { return mem_[0]; }
+  T const& front() const { return mem_[0]; }
+  T& back() { return mem_[size_ - 1U]; }
+  T const& back() const { return mem_[size_ - 1U]; }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    utl::verify(size_ < N, "inline_vector: capacity {} exceeded", N);
+    auto& el = mem_[size_];
+    el = T(std::forward<Args>(args)...);
+    ++size_;
+    return el;
+  }
+  void push_back(T const& el) { emplace_back(el); }
+  void push_back(T&& el) { emplace_back(std::move(el)); }
+  void pop_back() { mem_[--size_] = T{}; }
+
+  void resize(size_type const n) {
+    utl::verify(n <= N, "inline_vector: size {}, capacity {}", n, N);
+    for (auto i = n; i < size_; ++i) {
+      mem_[i] = T{};
+    }
+    size_ = static_cast<std::uint8_t>(n);
+  }
+  void clear() { resize(0U); }
+
+  friend bool operator==(inline_vector const& a, inline_vector const& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+  friend bool operator!=(inline_vector const& a, inline_vector const& b) {
+    return !(a == b);
+  }
+  template <typename Alloc>
+  friend bool operator==(inline_vector const& a,
+                         std::vector<T, Alloc> const& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+  template <typename Alloc>
+  friend bool operator!=(inline_vector const& a,
+                         std::vector<T, Alloc> const& b) {
+    return !(a == b);
+  }
+  template <typename Alloc>
+  friend bool operator==(std::vector<T, Alloc> const& a,
+                         inline_vector const& b) {
+    return b == a;
+  }
+  template <typename Alloc>
+  friend bool operator!=(std::vector<T, Alloc> const& a,
+                         inline_vector const& b) {
+    return b != a;
+  }
+
+  std::array<T, N> mem_{};  // [size_, N): value initialized
+  std::uint8_t size_{0U};
+};
+
+}  // namespace step
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace step {
+
+// STRING attribute stored once per model (express-gen --intern-strings).
+// Equal strings of the same string_pool share one entry: comparing two
+// interned strings compares handles.
+struct interned_string {
+  std::string_view view() const {
+    return entry_ == nullptr ? std::string_view{} : *entry_;
+  }
+  operator std::string_view() const { return view(); }  // NOLINT
+  std::string str() const { return std::string{view()}; }
+
+  char const* data() const { return view().data(); }
+  std::size_t size() const { return view().size(); }
+  bool empty() const { return entry_ == nullptr; }
+
+  friend bool operator==(interned_string a, interned_string b) {
+    return a.entry_ == b.entry_;
+  }
+  friend bool operator!=(interned_string a, interned_string b) {
+    return a.entry_ != b.entry_;
+  }
+  friend bool operator==(interned_string a, std::string_view b) {
+    return a.view() == b;
+  }
+  friend bool operator!=(interned_string a, std::string_view b) {
+    return a.view() != b;
+  }
+  friend bool operator==(std::string_view a, interned_string b) {
+    return b == a;
+  }
+  friend bool operator!=(std::string_view a, interned_string b) {
+    return b != a;
+  }
+
+  std::string_view const* entry_{nullptr};  // nullptr = empty string
+};
+
+}  // namespace step
+
+template <>
+struct std::hash<step::interned_string> {
+  std::size_t operator()(step::interned_string const s) const noexcept {
+    return std::hash<void const*>{}(s.entry_);
+  }
+};
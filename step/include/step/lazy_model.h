@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "utl/parser/cstr.h"
+#include "utl/verify.h"
+
+#include "step/entity_cast.h"
+#include "step/id_t.h"
+#include "step/map_file.h"
+#include "step/model.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_options.h"
+#include "step/parse_reachable.h"
+#include "step/record_index.h"
+#include "step/root_entity.h"
+
+namespace step {
+
+// Parses entities on first access. Construction only builds the record
+// index. get_entity() parses and resolves the requested entity together with
+// all entities it (transitively) references, so pointers of returned
+// entities are always resolved. Safe to use from multiple threads.
+template <typename Parser>
+struct lazy_model {
+  lazy_model(Parser p, utl::cstr input, parse_options const& opt = {},
+             std::shared_ptr<void> input_mem = {})
+      : parser_{std::move(p)},
+        index_{input, opt},
+        entities_{std::make_unique<std::atomic<root_entity*>[]>(  // NOLINT
+            index_.entries_.size())},
+        visited_(index_.entries_.size(), false),
+        diagnostics_{opt.diagnostics_},
+        input_mem_{std::move(input_mem)} {}
+
+  template <typename T>
+  T& get_entity(id_t const id) {
+    auto* const e = materialize(id);
+    utl::verify(e != nullptr, "invalid id");
+    auto* const entity = entity_cast<T>(e);
+    utl::verify(entity != nullptr, "bad cast");
+    return *entity;
+  }
+
+  // Returns nullptr for unknown ids and records the parser skips.
+  root_entity* materialize(id_t const id) {
+    auto const* const e = index_.find(id);
+    if (e == nullptr) {
+      return nullptr;
+    }
+    auto const idx = static_cast<std::size_t>(e - index_.entries_.data());
+    if (auto* const entity = entities_[idx].load(std::memory_order_acquire);
+        entity != nullptr) {
+      return entity;
+    }
+
+    auto const lock = std::lock_guard{mutex_};
+    if (!visited_[idx]) {
+      materialize_closure(idx);
+    }
+    return entities_[idx].load(std::memory_order_relaxed);
+  }
+
+  // Number of parsed entities.
+  std::size_t size() const {
+    auto const lock = std::lock_guard{mutex_};
+    return m_.entity_mem_.size();
+  }
+
+  void materialize_closure(std::size_t const root) {
+    auto printed = parse_diagnostics{};
+    auto& diag = diagnostics_ == nullptr ? printed : *diagnostics_;
+    visited_[root] = true;
+    auto const parsed = detail::parse_closure(parser_, index_, {root}, visited_,
+                                              m_.arena_, m_.strings_, diag);
+    detail::print_parse_errors(printed);
+    for (auto const& [idx, entity] : parsed) {
+      m_.entity_mem_.emplace_back(entity);
+      m_.id_to_entity_.insert(entity->id_, entity);
+    }
+
+    // Publish only after everything reachable is parsed and resolved.
+    for (auto const& [idx, entity] : parsed) {
+      entity->resolve(m_.id_to_entity_);
+    }
+    for (auto const& [idx, entity] : parsed) {
+      entities_[idx].store(entity, std::memory_order_release);
+    }
+  }
+
+  Parser parser_;
+  record_index index_;
+  std::unique_ptr<std::atomic<root_entity*>[]> entities_;  // NOLINT
+
+  mutable std::mutex mutex_;
+  std::vector<bool> visited_;  // guarded by mutex_
+  model m_;  // parsed entities, guarded by mutex_
+  parse_diagnostics* diagnostics_;  // see parse_options, guarded by mutex_
+
+  std::shared_ptr<void> input_mem_;
+};
+
+// The file stays mapped as long as the lazy model lives.
+template <typename Parser>
+lazy_model<Parser> parse_file_lazy(Parser p, char const* path,
+                                   parse_options const& opt = {}) {
+  auto mem = std::make_shared<cista::mmap>(map_file(path));
+  auto const input =
+      utl::cstr{reinterpret_cast<char const*>(mem->data()), mem->size()};
+  return lazy_model<Parser>{std::move(p), input, opt, std::move(mem)};
+}
+
+}  // namespace step
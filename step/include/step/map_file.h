@@ -0,0 +1,11 @@
+#pragma once
+
+#include "cista/mmap.h"
+
+namespace step {
+
+// Maps the file read-only and advises the OS that the mapping
+// will be read sequentially (and may be backed by huge pages).
+cista::mmap map_file(char const* path);
+
+}  // namespace step
@@ -1,16 +1,21 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
+#include "utl/parser/cstr.h"
 #include "utl/verify.h"
 
+#include "step/arena.h"
+#include "step/entity_cast.h"
+#include "step/id_index.h"
 #include "step/id_t.h"
+#include "step/ref.h"
+#include "step/string_pool.h"
 
 namespace step {
 
-struct root_entity;
-
 struct model {
   template <typename T>
   T const& get_entity(step::id_t const& id) const {
@@ -19,22 +24,58 @@ struct model {
 
   template <typename T>
   T& get_entity(step::id_t const& id) {
-    utl::verify(id_to_entity_.size() > id.id_, "invalid id");
-    auto* const entity = dynamic_cast<T*>(id_to_entity_[id.id_]);
+    auto* const e = id_to_entity_.find(id);
+    utl::verify(e != nullptr, "invalid id");
+    auto* const entity = entity_cast<T>(e);
     utl::verify(entity != nullptr, "bad cast");
     return *entity;
   }
 
+  // nullptr for null, dangling or mistyped references.
+  template <typename T>
+  T const* get(ref<T> const r) const {
+    return entity_cast<T>(id_to_entity_.find(r.id_));
+  }
+
+  template <typename T>
+  T* get(ref<T> const r) {
+    return entity_cast<T>(id_to_entity_.find(r.id_));
+  }
+
   template <typename T>
   T& add_entity() {
-    auto const e = entity_mem_.emplace_back(std::make_unique<T>()).get();
-    e->id_ = id_to_entity_.size();
-    id_to_entity_.push_back(e);
-    return *static_cast<T*>(e);
+    auto* const e = arena_.create<T>();
+    e->id_ = id_to_entity_.next_id();
+    entity_mem_.emplace_back(e);
+    id_to_entity_.insert(e->id_, e);
+    return *e;
   }
 
-  std::vector<root_entity*> id_to_entity_;
-  std::vector<std::unique_ptr<root_entity>> entity_mem_;
+  // Changes to parsed entities have to go through modify (or mark_dirty):
+  // incremental writes copy the input record of all other parsed entities.
+  template <typename T>
+  T& modify(step::id_t const& id) {
+    auto& e = get_entity<T>(id);
+    mark_dirty(e);
+    return e;
+  }
+
+  void mark_dirty(root_entity const& e) { dirty_.insert(&e); }
+
+  bool is_dirty(root_entity const& e) const {
+    return dirty_.find(&e) != end(dirty_);
+  }
+
+  id_index id_to_entity_;
+  std::vector<root_entity*> entity_mem_;  // insertion order, owned by arena_
+  arena arena_;
+  string_pool strings_;  // interned STRING attributes
+
+  // Input the model was parsed from (only set if it is kept alive).
+  utl::cstr input_;
+  std::shared_ptr<void> input_mem_;
+
+  std::unordered_set<root_entity const*> dirty_;  // see modify
 };
 
 }  // namespace step
\ No newline at end of file
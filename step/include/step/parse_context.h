@@ -0,0 +1,35 @@
+#pragma once
+
+#include "step/arena.h"
+#include "step/string_pool.h"
+
+namespace step {
+
+// Model storage for data created while parsing an attribute (unescaped
+// string_ref values, interned strings). Set per thread for the duration of a
+// parse, nullptr otherwise.
+struct parse_context {
+  arena* mem_{nullptr};
+  string_pool* strings_{nullptr};
+};
+
+inline parse_context& current_parse_context() {
+  thread_local parse_context ctx;
+  return ctx;
+}
+
+struct parse_context_scope {
+  explicit parse_context_scope(parse_context const& ctx)
+      : prev_{current_parse_context()} {
+    current_parse_context() = ctx;
+  }
+  parse_context_scope(parse_context_scope const&) = delete;
+  parse_context_scope(parse_context_scope&&) = delete;
+  parse_context_scope& operator=(parse_context_scope const&) = delete;
+  parse_context_scope& operator=(parse_context_scope&&) = delete;
+  ~parse_context_scope() { current_parse_context() = prev_; }
+
+  parse_context prev_;
+};
+
+}  // namespace step
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "step/id_t.h"
+#include "step/parse_error.h"
+
+namespace step {
+
+enum class error_policy : std::uint8_t {
+  kSkip,  // skip the record, keep a diagnostic
+  kCount,  // skip the record, only count it
+  kAbort  // keep a diagnostic and stop parsing
+};
+
+struct parse_diagnostic {
+  static constexpr auto const kUnknownLine =
+      std::numeric_limits<std::size_t>::max();
+
+  std::size_t line_idx_;  // line of the record start (0-based)
+  std::size_t offset_;  // byte offset of the error in the input
+  id_t id_;  // invalid if the record could not be split
+  std::string type_;
+  parse_error reason_;
+};
+
+// Collects parse errors instead of printing them.
+struct parse_diagnostics {
+  parse_diagnostics() = default;
+  explicit parse_diagnostics(error_policy const policy) : policy_{policy} {}
+
+  // Returns false if parsing has to stop.
+  bool report(std::size_t line_idx, std::size_t offset, id_t id,
+              std::string_view type, parse_error reason);
+
+  // Appends the diagnostics of a part of the input that starts at the given
+  // line / byte offset.
+  void append(parse_diagnostics const&, std::size_t line_offset,
+              std::size_t byte_offset);
+
+  error_policy policy_{error_policy::kSkip};
+  std::size_t n_errors_{0U};
+  bool aborted_{false};
+  std::vector<parse_diagnostic> errors_;  // empty with error_policy::kCount
+};
+
+namespace detail {
+
+void print_parse_errors(parse_diagnostics const&);
+
+}  // namespace detail
+
+}  // namespace step
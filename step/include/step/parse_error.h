@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace step {
+
+// Returned by parse_step: malformed input is reported by value, not by
+// exception.
+enum class parse_error : std::uint8_t {
+  kNone,
+  kBadRecord,  // not "#id = NAME(attributes);"
+  kExpectedId,
+  kExpectedInteger,
+  kExpectedReal,
+  kExpectedBool,
+  kExpectedLogical,
+  kExpectedString,
+  kExpectedList,
+  kListTooLong,
+  kExpectedEnum,
+  kUnknownEnumValue,
+  kExpectedSelect,
+  kUnknownSelect,
+  kIncompleteRecord  // input ends inside a record
+};
+
+std::string_view to_str(parse_error);
+
+}  // namespace step
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+#include "utl/parser/cstr.h"
+
+#include "step/map_file.h"
+#include "step/model.h"
+#include "step/parse_lines.h"
+#include "step/parse_options.h"
+
+namespace step {
+
+template <typename Parser>
+model parse_file(Parser const& p, char const* path,
+                 parse_options const& opt = {}) {
+  auto mem = std::make_shared<cista::mmap>(map_file(path));
+  auto const input =
+      utl::cstr{reinterpret_cast<char const*>(mem->data()), mem->size()};
+  auto m = parse_lines(p, input, opt);
+  if (opt.keep_input_) {
+    m.input_mem_ = std::move(mem);
+  }
+  return m;
+}
+
+}  // namespace step
@@ -1,45 +1,135 @@
 #pragma once
 
-#include <optional>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "utl/enumerate.h"
 #include "utl/parser/cstr.h"
 
-#include "fmt/core.h"
-
+#include "step/arena.h"
 #include "step/model.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_options.h"
+#include "step/parse_records.h"
+#include "step/resolve_entities.h"
 #include "step/root_entity.h"
-#include "step/split_line.h"
+#include "step/split_chunks.h"
+#include "step/thread_count.h"
 
 namespace step {
 
+namespace detail {
+
+struct parsed_chunk {
+  arena mem_;
+  std::vector<root_entity*> entities_;
+  parse_diagnostics diagnostics_;
+};
+
+inline void add_parsed_entity(model& m, root_entity* e) {
+  m.entity_mem_.emplace_back(e);
+  m.id_to_entity_.insert(e->id_, e);
+}
+
 template <typename Parser>
-model parse_lines(Parser const& p, utl::cstr step) {
-  model m;
-  for (auto [line_idx, line] : utl::enumerate(utl::lines{step})) {
-    try {
-      auto const split = split_line(line);
-      if (!split.has_value()) {
-        continue;
-      }
+void parse_lines_parallel(Parser const& p, utl::cstr step,
+                          unsigned const n_threads, model& m,
+                          parse_diagnostics& diag) {
+  // More chunks than threads: workers that finish early pick up the rest.
+  auto const chunks = split_chunks(step, n_threads * 4U);
+  auto parsed = std::vector<parsed_chunk>(chunks.size());
+  for (auto& c : parsed) {
+    c.diagnostics_.policy_ = diag.policy_;
+  }
 
-      auto entity = p.parse(split->name_, split->entity_);
-      if (!entity.has_value()) {
-        continue;
+  // Chunks behind an aborted chunk are not needed.
+  auto first_aborted = std::atomic_size_t{chunks.size()};
+  auto next_chunk = std::atomic_size_t{0U};
+  auto worker_errors = std::vector<std::exception_ptr>(n_threads);
+  auto workers = std::vector<std::thread>{};
+  workers.reserve(n_threads);
+  for (auto t = 0U; t != n_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      try {
+        for (auto i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+          if (i > first_aborted.load()) {
+            break;
+          }
+          auto& out = parsed[i];
+          parse_records(
+              p, out.mem_, m.strings_, chunks[i],
+              [&](root_entity* e) { out.entities_.emplace_back(e); },
+              out.diagnostics_);
+          if (out.diagnostics_.aborted_) {
+            auto prev = first_aborted.load();
+            while (i < prev && !first_aborted.compare_exchange_weak(prev, i)) {
+            }
+          }
+        }
+      } catch (...) {
+        worker_errors[t] = std::current_exception();
       }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  for (auto const& e : worker_errors) {
+    if (e != nullptr) {
+      std::rethrow_exception(e);
+    }
+  }
 
-      auto* const e_ptr = m.entity_mem_.emplace_back(std::move(*entity)).get();
-      e_ptr->id_ = split->id_;
-      if (m.id_to_entity_.size() <= split->id_.id_) {
-        m.id_to_entity_.resize(split->id_.id_ + 1);
-      }
-      m.id_to_entity_[split->id_.id_] = e_ptr;
-    } catch (std::exception const& e) {
-      fmt::print("unable to parse line {}: {}\n", line_idx + 1, line.view());
+  // Merge in chunk order: same entity order and id mapping as serial parsing.
+  auto n_entities = std::size_t{0U};
+  for (auto const& c : parsed) {
+    n_entities += c.entities_.size();
+  }
+  m.entity_mem_.reserve(n_entities);
+
+  auto line_offset = std::size_t{0U};
+  for (auto const& [chunk, c] : utl::enumerate(chunks)) {
+    auto const byte_offset = static_cast<std::size_t>(c.str - step.str);
+    m.arena_.merge(std::move(parsed[chunk].mem_));
+    for (auto* const e : parsed[chunk].entities_) {
+      e->source_offset_ += byte_offset;
+      add_parsed_entity(m, e);
     }
+    diag.append(parsed[chunk].diagnostics_, line_offset, byte_offset);
+    if (diag.aborted_) {
+      break;
+    }
+    line_offset += static_cast<std::size_t>(
+        std::count(c.str, c.str + c.len, '\n'));  // NOLINT
+  }
+}
+
+}  // namespace detail
+
+template <typename Parser>
+model parse_lines(Parser const& p, utl::cstr step,
+                  parse_options const& opt = {}) {
+  auto const n_threads = thread_count(opt.threads_);
+
+  auto printed = parse_diagnostics{};
+  auto& diag = opt.diagnostics_ == nullptr ? printed : *opt.diagnostics_;
+
+  model m;
+  if (n_threads == 1U) {
+    detail::parse_records(
+        p, m.arena_, m.strings_, step,
+        [&](root_entity* e) { detail::add_parsed_entity(m, e); }, diag);
+  } else {
+    detail::parse_lines_parallel(p, step, n_threads, m, diag);
   }
-  for (auto& ptr : m.entity_mem_) {
-    ptr->resolve(m.id_to_entity_);
+  resolve_entities(m, n_threads);
+  detail::print_parse_errors(printed);
+  if (opt.keep_input_) {
+    m.input_ = step;
   }
   return m;
 }
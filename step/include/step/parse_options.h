@@ -0,0 +1,22 @@
+#pragma once
+
+namespace step {
+
+struct parse_diagnostics;
+
+struct parse_options {
+  // Number of worker threads used to parse the input.
+  // 0 = one per hardware thread, 1 = serial parsing on the calling thread.
+  unsigned threads_{1U};
+
+  // Set model::input_ to the parsed input (required by incremental writing).
+  // parse_file keeps the file mapped as long as the model lives, otherwise
+  // the caller has to keep the input alive.
+  bool keep_input_{false};
+
+  // Receives parse errors and decides whether to skip records or to stop.
+  // nullptr: skip records with errors and print them to stdout.
+  parse_diagnostics* diagnostics_{nullptr};
+};
+
+}  // namespace step
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "utl/parser/cstr.h"
+
+#include "step/arena.h"
+#include "step/id_t.h"
+#include "step/model.h"
+#include "step/parse_context.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_error.h"
+#include "step/parse_options.h"
+#include "step/record_index.h"
+#include "step/record_scanner.h"
+#include "step/resolve_entities.h"
+#include "step/root_entity.h"
+#include "step/split_line.h"
+#include "step/string_pool.h"
+
+namespace step {
+
+namespace detail {
+
+// Parses the records on the stack and all records they (transitively)
+// reference that are not visited yet. Records on the stack have to be marked
+// as visited. Returns the parsed entities with their index entry (unresolved).
+// If diag aborts, records not parsed yet are marked as unvisited again.
+template <typename Parser>
+std::vector<std::pair<std::size_t, root_entity*>> parse_closure(
+    Parser const& p, record_index const& index, std::vector<std::size_t> stack,
+    std::vector<bool>& visited, arena& mem, string_pool& strings,
+    parse_diagnostics& diag) {
+  auto const scope = parse_context_scope{parse_context{&mem, &strings}};
+  auto parsed = std::vector<std::pair<std::size_t, root_entity*>>{};
+  auto refs = std::vector<id_t>{};
+  while (!stack.empty()) {
+    auto const idx = stack.back();
+    stack.pop_back();
+
+    auto const& record = index.entries_[idx];
+    auto const str = index.str(record);
+    auto err = parse_error::kNone;
+    auto const split = split_line(str, err);
+    auto rest = split.has_value() ? split->entity_ : str;
+    root_entity* entity = nullptr;
+    if (split.has_value()) {
+      err = p.parse(mem, split->name_, rest, entity);
+    }
+    if (err != parse_error::kNone) {
+      auto const type = split.has_value() ? split->name_.view() : "";
+      if (!diag.report(parse_diagnostic::kUnknownLine,
+                       record.offset_ + static_cast<std::size_t>(
+                                            rest.str - str.str),
+                       record.id_, type, err)) {
+        for (auto const i : stack) {
+          visited[i] = false;
+        }
+        break;
+      }
+      continue;
+    }
+    if (entity == nullptr) {
+      continue;
+    }
+    entity->id_ = split->id_;
+    entity->source_offset_ = record.offset_;
+    entity->source_len_ = record.size_;
+    parsed.emplace_back(idx, entity);
+
+    refs.clear();
+    collect_references(split->entity_, refs);
+    for (auto const ref : refs) {
+      if (auto const* const r = index.find(ref); r != nullptr) {
+        auto const ref_idx =
+            static_cast<std::size_t>(r - index.entries_.data());
+        if (!visited[ref_idx]) {
+          visited[ref_idx] = true;
+          stack.emplace_back(ref_idx);
+        }
+      }
+    }
+  }
+  return parsed;
+}
+
+}  // namespace detail
+
+// Parses all entities of the root types (exact type names, no subtypes) and
+// all entities they (transitively) reference. Other records are skipped.
+// Pointers of parsed entities are resolved like with parse_lines.
+template <typename Parser>
+model parse_reachable(Parser const& p, utl::cstr step,
+                      std::vector<std::string_view> const& root_types,
+                      parse_options const& opt = {}) {
+  auto const index = record_index{step, opt};
+
+  auto root_hashes = std::vector<cista::hash_t>{};
+  for (auto const& type : root_types) {
+    root_hashes.emplace_back(cista::hash(type));
+  }
+  auto const is_root = [&](record_index::entry const& e) {
+    auto const it = std::find(begin(root_hashes), end(root_hashes), e.type_);
+    return it != end(root_hashes) &&
+           index.split(e).name_.view() ==
+               root_types[static_cast<std::size_t>(it - begin(root_hashes))];
+  };
+
+  auto visited = std::vector<bool>(index.entries_.size(), false);
+  auto stack = std::vector<std::size_t>{};
+  for (auto i = index.entries_.size(); i != 0U; --i) {
+    if (is_root(index.entries_[i - 1U])) {
+      visited[i - 1U] = true;
+      stack.emplace_back(i - 1U);
+    }
+  }
+
+  auto printed = parse_diagnostics{};
+  auto& diag = opt.diagnostics_ == nullptr ? printed : *opt.diagnostics_;
+
+  model m;
+  auto parsed = detail::parse_closure(p, index, std::move(stack), visited,
+                                      m.arena_, m.strings_, diag);
+  detail::print_parse_errors(printed);
+
+  // Same entity order as parse_lines: input order.
+  std::sort(begin(parsed), end(parsed), [&](auto const& a, auto const& b) {
+    return index.entries_[a.first].offset_ < index.entries_[b.first].offset_;
+  });
+  m.entity_mem_.reserve(parsed.size());
+  for (auto const& [idx, entity] : parsed) {
+    m.entity_mem_.emplace_back(entity);
+    m.id_to_entity_.insert(entity->id_, entity);
+  }
+  resolve_entities(m, opt.threads_);
+  if (opt.keep_input_) {
+    m.input_ = step;
+  }
+  return m;
+}
+
+}  // namespace step
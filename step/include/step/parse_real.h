@@ -0,0 +1,15 @@
+#pragma once
+
+#include "utl/parser/cstr.h"
+
+#include "step/parse_error.h"
+
+namespace step {
+
+// Parses a REAL ([+-]digits[.digits][E[+-]digits]) at the front of s and
+// advances s behind it. Never reads past s.len and ignores the C locale.
+// Results are correctly rounded: short mantissas are converted exactly,
+// everything else is handed to std::from_chars. On error, s is unchanged.
+parse_error parse_real(utl::cstr& s, double& val);
+
+}  // namespace step
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utl/parser/cstr.h"
+
+#include "step/arena.h"
+#include "step/parse_context.h"
+#include "step/parse_diagnostics.h"
+#include "step/parse_error.h"
+#include "step/record_scanner.h"
+#include "step/root_entity.h"
+#include "step/string_pool.h"
+#include "step/split_line.h"
+
+namespace step {
+
+namespace detail {
+
+// Parses all records of the input. Errors are reported to diag with lines
+// and byte offsets relative to the input. Parsing stops when diag is
+// aborted. Returns the incomplete trailing record (empty if the input ends
+// with a complete record), which is reported as error unless
+// report_incomplete is false.
+template <typename Parser, typename EntityFn>
+record parse_records(Parser const& p, arena& mem, string_pool& strings,
+                     utl::cstr step, EntityFn&& on_entity,
+                     parse_diagnostics& diag,
+                     bool const report_incomplete = true) {
+  auto const scope = parse_context_scope{parse_context{&mem, &strings}};
+  auto const offset = [&](char const* pos) {
+    return static_cast<std::size_t>(pos - step.str);
+  };
+
+  auto scanner = record_scanner{step};
+  while (auto const r = scanner.next()) {
+    auto err = parse_error::kNone;
+    auto const split = split_line(r->str_, err);
+    if (!split.has_value()) {
+      if (err != parse_error::kNone &&
+          !diag.report(r->line_idx_, offset(r->str_.str), id_t::invalid(), {},
+                       err)) {
+        break;
+      }
+      continue;
+    }
+
+    auto rest = split->entity_;
+    root_entity* entity = nullptr;
+    err = p.parse(mem, split->name_, rest, entity);
+    if (err != parse_error::kNone) {
+      if (!diag.report(r->line_idx_, offset(rest.str), split->id_,
+                       split->name_.view(), err)) {
+        break;
+      }
+      continue;
+    }
+    if (entity != nullptr) {
+      entity->id_ = split->id_;
+      entity->source_offset_ = offset(r->str_.str);
+      entity->source_len_ = static_cast<std::uint32_t>(r->str_.len);
+      on_entity(entity);
+    }
+  }
+
+  auto const rest = record{scanner.in_, scanner.line_idx_};
+  if (report_incomplete && !diag.aborted_ && rest.str_.len != 0U) {
+    diag.report(rest.line_idx_, offset(rest.str_.str), id_t::invalid(), {},
+                parse_error::kIncompleteRecord);
+  }
+  return rest;
+}
+
+}  // namespace detail
+
+}  // namespace step
@@ -1,19 +1,29 @@
 #pragma once
 
+#include <cstring>
 #include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "boost/algorithm/string.hpp"
 
-#include "cista/type_hash/type_name.h"
-
 #include "utl/parser/arg_parser.h"
 #include "utl/parser/cstr.h"
 #include "utl/verify.h"
 
 #include "step/exp_logical.h"
 #include "step/id_t.h"
+#include "step/inline_vector.h"
 #include "step/is_collection.h"
+#include "step/interned_string.h"
+#include "step/parse_context.h"
+#include "step/parse_error.h"
+#include "step/parse_real.h"
+#include "step/ref.h"
+#include "step/string_ref.h"
 
 namespace step {
 
@@ -38,122 +48,282 @@ inline std::optional<utl::cstr> get_next_token(utl::cstr const s, char token) {
   return utl::cstr{pos + 1, s.len - (pos - s.str) - 1};
 }
 
-inline void parse_step(utl::cstr& in, id_t& i) {
-  utl::verify(in.len > 1 && (in[0] == '$' ||
-                             (in[0] == '#' && (std::isdigit(in[1]) != 0))),
-              "expected id, got: {}", in.view());
-  if (in[0] == '$') {
+// An unset reference ($) is parsed as invalid id (resolved to nullptr).
+inline parse_error parse_step(utl::cstr& in, id_t& i) {
+  if (in.len > 0 && in[0] == '$') {
     ++in;
-    fmt::print("warning: id set to $, unable to resolve (-> nullptr)\n");
     i.id_ = id_t::kInvalid;
-  } else {
-    ++in;
-    utl::parse_arg(in, i.id_);
+    return parse_error::kNone;
   }
+  if (in.len < 2 || in[0] != '#' || std::isdigit(in[1]) == 0) {
+    return parse_error::kExpectedId;
+  }
+  ++in;
+  utl::parse_arg(in, i.id_);
+  return parse_error::kNone;
 }
 
 template <typename T>
-void parse_step(utl::cstr& s, T*& ptr) {
+parse_error parse_step(utl::cstr& s, T*& ptr) {
   auto id = step::id_t{};
-  parse_step(s, id);
+  auto const err = parse_step(s, id);
   ptr = reinterpret_cast<T*>(static_cast<uintptr_t>(id.id_));
+  return err;
 }
 
-inline void parse_step(utl::cstr& s, double& val) {
-  char* end = nullptr;
-  val = std::strtod(s.str, &end);
-  s.len -= end - s.str;
-  s.str = end;
+template <typename T>
+parse_error parse_step(utl::cstr& s, ref<T>& r) {
+  return parse_step(s, r.id_);
+}
+
+inline parse_error parse_step(utl::cstr& s, double& val) {
+  return parse_real(s, val);
 }
 
 template <typename T>
-std::enable_if_t<std::is_integral_v<T>> parse_step(utl::cstr& s, T& val) {
+std::enable_if_t<std::is_integral_v<T>, parse_error> parse_step(utl::cstr& s,
+                                                                T& val) {
+  auto const* const before = s.str;
   utl::parse_arg(s, val);
+  return s.str == before ? parse_error::kExpectedInteger : parse_error::kNone;
 }
 
-inline void parse_step(utl::cstr& s, bool& val) {
-  utl::verify(s.len > 0 && s[0] == '.', "expected bool, got {}", s.view());
-  ++s;
+inline parse_error parse_step(utl::cstr& s, bool& val) {
+  if (s.len < 3 || s[0] != '.' || (s[1] != 'T' && s[1] != 'F') ||
+      s[2] != '.') {
+    return parse_error::kExpectedBool;
+  }
+  val = s[1] == 'T';
+  s += 3U;
+  return parse_error::kNone;
+}
 
-  utl::verify(s.len > 0 && (s[0] == 'T' || s[0] == 'F'),
-              "expected bool '.T.' or '.F.', got {}", s.view());
-  val = s[0] == 'T';
-  ++s;
+inline parse_error parse_step(utl::cstr& s, exp_logical& val) {
+  if (s.len < 3 || s[0] != '.' ||
+      (s[1] != 'T' && s[1] != 'F' && s[1] != 'U') || s[2] != '.') {
+    return parse_error::kExpectedLogical;
+  }
+  switch (s[1]) {
+    case 'T': val = exp_logical::EXP_TRUE; break;
+    case 'F': val = exp_logical::EXP_FALSE; break;
+    case 'U': val = exp_logical::EXP_UNKNOWN; break;
+  }
+  s += 3U;
+  return parse_error::kNone;
+}
 
-  utl::verify(s.len > 0 && s[0] == '.', "expected bool, got {}", s.view());
-  ++s;
+namespace detail {
+
+// Raw content of the quoted string at the front of s ('' escapes still in
+// place) and the number of escaped quotes. Advances s behind the string.
+// Returns std::nullopt (s unchanged) if s does not start with a string.
+inline std::optional<std::pair<utl::cstr, std::size_t>> parse_quoted(
+    utl::cstr& s) {
+  if (s.len == 0 || s[0] != '\'') {
+    return std::nullopt;
+  }
+
+  auto n_escaped = std::size_t{0U};
+  auto pos = std::size_t{1U};
+  while (true) {
+    auto const* const quote = static_cast<char const*>(
+        std::memchr(s.str + pos, '\'', s.len - pos));  // NOLINT
+    if (quote == nullptr) {
+      return std::nullopt;
+    }
+    pos = static_cast<std::size_t>(quote - s.str);
+    if (pos + 1U < s.len && s[pos + 1U] == '\'') {
+      ++n_escaped;
+      pos += 2U;
+    } else {
+      break;
+    }
+  }
+
+  auto const raw = utl::cstr{s.str + 1, pos - 1U};  // NOLINT
+  s += pos + 1U;
+  return std::pair{raw, n_escaped};
 }
 
-inline void parse_step(utl::cstr& s, exp_logical& val) {
-  utl::verify(s.len > 0 && s[0] == '.', "expected bool, got {}", s.view());
-  ++s;
+// Copies raw to out, replacing '' by '. Returns the end of the output.
+inline char* unescape_quotes(utl::cstr const raw, char* out) {
+  for (auto i = std::size_t{0U}; i != raw.len; ++i) {
+    *out++ = raw[i];
+    if (raw[i] == '\'') {
+      ++i;
+    }
+  }
+  return out;
+}
 
-  utl::verify(s.len > 0 && (s[0] == 'T' || s[0] == 'F' || s[0] == 'U'),
-              "expected logical '.T.', '.F.', or '.U.', got {}", s.view());
-  switch (s[0]) {
-    case 'T': val = exp_logical::EXP_TRUE;
-    case 'F': val = exp_logical::EXP_FALSE;
-    case 'U': val = exp_logical::EXP_UNKNOWN;
+}  // namespace detail
+
+inline parse_error parse_step(utl::cstr& s, std::string& str) {
+  auto const quoted = detail::parse_quoted(s);
+  if (!quoted.has_value()) {
+    return parse_error::kExpectedString;
   }
-  ++s;
+  auto const [raw, n_escaped] = *quoted;
+  if (n_escaped == 0U) {
+    str.assign(raw.str, raw.len);
+  } else {
+    str.resize(raw.len - n_escaped);
+    detail::unescape_quotes(raw, str.data());
+  }
+  return parse_error::kNone;
+}
 
-  utl::verify(s.len > 0 && s[0] == '.', "expected bool, got {}", s.view());
-  ++s;
+// Points into the input unless the value contains escaped quotes: these are
+// unescaped into the arena of the current_parse_context().
+inline parse_error parse_step(utl::cstr& s, string_ref& str) {
+  auto const quoted = detail::parse_quoted(s);
+  if (!quoted.has_value()) {
+    return parse_error::kExpectedString;
+  }
+  auto const [raw, n_escaped] = *quoted;
+  if (n_escaped == 0U) {
+    str = string_ref{raw.str, raw.len};
+  } else {
+    auto* const mem = current_parse_context().mem_;
+    utl::verify(mem != nullptr, "no parse arena for string {}", raw.view());
+    auto* const out = mem->allocate_bytes(raw.len - n_escaped);
+    str = string_ref{out, raw.len - n_escaped};
+    detail::unescape_quotes(raw, out);
+  }
+  return parse_error::kNone;
 }
 
-inline void parse_step(utl::cstr& s, std::string& str) {
-  utl::verify(s.len > 0 && s[0] == '\'', "string starts with ', got {}",
-              s.view());
+// Interned in the string pool of the current_parse_context().
+inline parse_error parse_step(utl::cstr& s, interned_string& str) {
+  auto const quoted = detail::parse_quoted(s);
+  if (!quoted.has_value()) {
+    return parse_error::kExpectedString;
+  }
+  auto const [raw, n_escaped] = *quoted;
+  auto* const strings = current_parse_context().strings_;
+  utl::verify(strings != nullptr, "no string pool for string {}", raw.view());
+  if (n_escaped == 0U) {
+    str = strings->intern(raw.view());
+  } else {
+    auto unescaped = std::string(raw.len - n_escaped, '\0');
+    detail::unescape_quotes(raw, unescaped.data());
+    str = strings->intern(unescaped);
+  }
+  return parse_error::kNone;
+}
+
+namespace detail {
+
+// Numeric lists (coordinates, directions, ...) make up most of the input:
+// parse them without per-element resize() and overload dispatch.
+template <typename Vec>
+parse_error parse_number_list(utl::cstr& s, Vec& v) {
+  if (s.len != 0 && s[0] == '$') {  // invalid IFC handled gracefully
+    ++s;
+    return parse_error::kNone;
+  }
+
+  if (s.len == 0 || s[0] != '(') {
+    return parse_error::kExpectedList;
+  }
   ++s;
+  v.clear();
+  s = s.skip_whitespace_front();
+  while (s.len > 0 && s[0] != ')') {
+    if (v.size() == v.max_size()) {
+      return parse_error::kListTooLong;
+    }
+    if (auto const err = parse_step(s, v.emplace_back());
+        err != parse_error::kNone) {
+      return err;
+    }
+    s = s.skip_whitespace_front();
+    if (s.len > 0 && s[0] == ',') {
+      ++s;
+      s = s.skip_whitespace_front();
+    }
+  }
+  if (s.len == 0) {
+    return parse_error::kExpectedList;
+  }
+  ++s;
+  return parse_error::kNone;
+}
 
-  auto const end = get_next_token(s, '\'');
-  utl::verify(end.has_value(), "string ends with ', got {}", s.view());
+}  // namespace detail
+
+inline parse_error parse_step(utl::cstr& s, std::vector<double>& v) {
+  return detail::parse_number_list(s, v);
+}
+
+inline parse_error parse_step(utl::cstr& s, std::vector<int>& v) {
+  return detail::parse_number_list(s, v);
+}
 
-  str = std::string{s.data(), static_cast<size_t>(end->data() - s.data() - 1)};
-  s = *end;
+template <typename T, std::size_t N>
+std::enable_if_t<std::is_same_v<T, double> || std::is_same_v<T, int>,
+                 parse_error>
+parse_step(utl::cstr& s, inline_vector<T, N>& v) {
+  return detail::parse_number_list(s, v);
 }
 
 template <typename T>
-std::enable_if_t<is_collection<T>::value> parse_step(utl::cstr& s, T& v) {
+std::enable_if_t<is_collection<T>::value, parse_error> parse_step(utl::cstr& s,
+                                                                  T& v) {
   if (s.len != 0 && s[0] == '$') {  // invalid IFC handled gracefully
     ++s;
-    return;
+    return parse_error::kNone;
   }
 
-  utl::verify(s.len != 0 && s[0] == '(', "set begins with (, got {}", s.view());
+  if (s.len == 0 || s[0] != '(') {
+    return parse_error::kExpectedList;
+  }
   ++s;
-  auto i = 0U;
+  auto i = std::size_t{0U};
   while (s.len > 0 && s[0] != ')') {
+    if (i == v.max_size()) {
+      return parse_error::kListTooLong;
+    }
+    auto err = parse_error::kNone;
     if constexpr (has_resize<T>::value) {
-      v.resize(i + 1);
+      err = parse_step(s, v.emplace_back());
+    } else {
+      err = parse_step(s, v[i]);
+    }
+    if (err != parse_error::kNone) {
+      return err;
     }
-    parse_step(s, v[i]);
     if (s.len > 0 && s[0] == ',') {
       ++s;
       s = s.skip_whitespace_front();
     }
     ++i;
   }
-  utl::verify(s.len != 0 && s[0] == ')', "set ends with ), got {}",
-              s.len > 0 ? s[0] : '?');
+  if (s.len == 0) {
+    return parse_error::kExpectedList;
+  }
   ++s;
+  return parse_error::kNone;
 }
 
 template <typename T>
-std::enable_if_t<std::is_enum_v<T>> parse_step(utl::cstr& s, T& v) {}
+std::enable_if_t<std::is_enum_v<T>, parse_error> parse_step(utl::cstr&, T&) {
+  return parse_error::kNone;
+}
 
 template <typename T>
-void parse_step(utl::cstr& s, std::optional<T>& o) {
-  utl::verify(s.len > 0, "expected optional {}, got {}", cista::type_str<T>(),
-              s.view());
-  if (s[0] == '$') {
+parse_error parse_step(utl::cstr& s, std::optional<T>& o) {
+  if (s.len != 0 && s[0] == '$') {
     ++s;
     o = std::nullopt;
-  } else {
-    T arg;
-    parse_step(s, arg);
-    o = std::move(arg);
+    return parse_error::kNone;
+  }
+  T arg{};
+  if (auto const err = parse_step(s, arg); err != parse_error::kNone) {
+    return err;
   }
+  o = std::move(arg);
+  return parse_error::kNone;
 }
 
 }  // namespace step
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "cista/hash.h"
+
+namespace step {
+
+constexpr std::uint64_t perfect_hash_mix(std::uint64_t h) {
+  h ^= h >> 33U;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33U;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33U;
+  return h;
+}
+
+// Both sizes are powers of two.
+inline std::size_t perfect_hash_slot(cista::hash_t const h,
+                                     std::uint32_t const* displacements,
+                                     std::size_t const n_displacements,
+                                     std::size_t const n_slots) {
+  auto const bucket = perfect_hash_mix(h) >> 32U;  // FNV high bits are weak
+  auto const d = displacements[bucket & (n_displacements - 1U)];
+  return static_cast<std::size_t>(perfect_hash_mix(h ^ d) & (n_slots - 1U));
+}
+
+// Perfect hash (hash and displace) over a fixed set of keys: every key
+// gets its own slot. Other strings map to arbitrary slots, so lookups
+// have to compare the key stored in the slot.
+struct perfect_hash {
+  static constexpr auto const kEmpty =
+      std::numeric_limits<std::uint32_t>::max();
+
+  std::size_t slot(std::string_view const key) const {
+    return perfect_hash_slot(cista::hash(key), displacements_.data(),
+                             displacements_.size(), slots_.size());
+  }
+
+  std::vector<std::uint32_t> displacements_;
+  std::vector<std::uint32_t> slots_;  // key index or kEmpty
+};
+
+// Throws if two keys have the same cista::hash.
+perfect_hash build_perfect_hash(std::vector<std::string_view> const& keys);
+
+}  // namespace step
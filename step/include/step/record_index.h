@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "cista/hash.h"
+
+#include "utl/parser/cstr.h"
+
+#include "step/id_t.h"
+#include "step/parse_options.h"
+#include "step/split_line.h"
+
+namespace step {
+
+// Location of every record (#id = NAME(...);) in the input, sorted by id.
+// Built by scanning the input without parsing attributes.
+struct record_index {
+  struct entry {
+    unsigned id_;
+    std::uint32_t size_;
+    std::size_t offset_;
+    cista::hash_t type_;  // cista::hash of the upper case type name
+  };
+
+  record_index() = default;
+  explicit record_index(utl::cstr input, parse_options const& = {});
+
+  entry const* find(id_t) const;
+  std::vector<id_t> ids_of(std::string_view type_name) const;
+
+  utl::cstr str(entry const& e) const {
+    return utl::cstr{input_.str + e.offset_, e.size_};  // NOLINT
+  }
+  line split(entry const& e) const;
+
+  utl::cstr input_;
+  std::vector<entry> entries_;
+};
+
+}  // namespace step
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "utl/parser/cstr.h"
+
+#include "step/id_t.h"
+
+namespace step {
+
+// One statement of the input, from its first character up to and including
+// the terminating ';' (e.g. "#12 = IFCDIRECTION((0.,0.,1.));").
+struct record {
+  utl::cstr str_;
+  std::size_t line_idx_;  // line of the first character
+};
+
+// Splits the input into records in a single pass. Only quotes, ';', '/' and
+// line breaks are inspected (16 bytes at a time with SSE2). A ';' inside a
+// string ('' escapes included) or a /* comment */ does not end a record, and
+// records may span multiple lines. Comments between records are skipped.
+struct record_scanner {
+  explicit record_scanner(utl::cstr in, std::size_t line_idx = 0U)
+      : in_{in}, line_idx_{line_idx} {}
+
+  // Returns std::nullopt at the end of the input. in_ then holds an
+  // incomplete trailing record (without terminating ';') or is empty.
+  std::optional<record> next();
+
+  utl::cstr in_;  // not yet scanned
+  std::size_t line_idx_;  // line of in_.str
+};
+
+// Appends the ids of all references (#123) in the attributes of a record.
+// References inside strings are skipped.
+void collect_references(utl::cstr attributes, std::vector<id_t>& refs);
+
+// Points behind the first line ending with a record terminator ';' at or after
+// pos (or to end). Scanning starts at begin, which has to be a record boundary,
+// so a ';' inside a string or a comment is no terminator.
+char const* next_record_boundary(char const* begin, char const* pos,
+                                 char const* end);
+
+}  // namespace step
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <type_traits>
+
+#include "step/id_t.h"
+
+namespace step {
+
+// 4 byte entity reference (express-gen --compact-refs) instead of T*.
+// Holds the id of the referenced entity: dereferenced through the model
+// (model::get), so it stays valid when the model is moved or snapshotted.
+template <typename T>
+struct ref {
+  ref() = default;
+  explicit ref(id_t const id) : id_{id} {}
+
+  bool valid() const { return id_ != id_t::invalid(); }
+  explicit operator bool() const { return valid(); }
+
+  friend bool operator==(ref const a, ref const b) { return a.id_ == b.id_; }
+  friend bool operator!=(ref const a, ref const b) { return a.id_ != b.id_; }
+
+  id_t id_;
+};
+
+template <typename T>
+struct is_ref : std::false_type {};
+
+template <typename T>
+struct is_ref<ref<T>> : std::true_type {};
+
+}  // namespace step
@@ -1,39 +1,51 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
-#include <vector>
 
 #include "step/has_data.h"
+#include "step/id_index.h"
 #include "step/is_collection.h"
+#include "step/ref.h"
 #include "step/root_entity.h"
 
 namespace step {
 
 template <typename T>
-void resolve(std::vector<root_entity*> const& v, T*& el) {
-  auto const id = reinterpret_cast<std::size_t>(el);
-  el = (v.size() <= id) ? nullptr : reinterpret_cast<T*>(v[id]);
+void resolve(id_index const& index, T*& el) {
+  auto const id = reinterpret_cast<std::uintptr_t>(el);
+  el = (id >= id_t::kInvalid)
+           ? nullptr
+           : reinterpret_cast<T*>(index.find(static_cast<unsigned>(id)));
 }
 
+// Only checks the reference: dangling references become null.
 template <typename T>
-std::enable_if_t<is_collection<T>::value> resolve(
-    std::vector<root_entity*> const& v, T& vec) {
+void resolve(id_index const& index, ref<T>& r) {
+  if (r.valid() && index.find(r.id_) == nullptr) {
+    r = ref<T>{};
+  }
+}
+
+template <typename T>
+std::enable_if_t<is_collection<T>::value> resolve(id_index const& index,
+                                                  T& vec) {
   for (auto& el : vec) {
-    resolve(v, el);
+    resolve(index, el);
   }
 }
 
 template <typename T>
-std::enable_if_t<has_data<T>::value> resolve(std::vector<root_entity*> const& v,
+std::enable_if_t<has_data<T>::value> resolve(id_index const& index,
                                              T& select) {
-  select.resolve(v);
+  select.resolve(index);
 }
 
 template <typename T>
-void resolve(std::vector<root_entity*> const& v, std::optional<T>& opt) {
+void resolve(id_index const& index, std::optional<T>& opt) {
   if (opt.has_value()) {
-    resolve(v, *opt);
+    resolve(index, *opt);
   }
 }
 
-}  // namespace step
\ No newline at end of file
+}  // namespace step
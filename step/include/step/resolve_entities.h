@@ -0,0 +1,14 @@
+#pragma once
+
+namespace step {
+
+struct model;
+
+// Replaces the ids stored in entity pointer members of all entities in
+// entity_mem_ with the referenced entities. Entities only write their own
+// members: consecutive ranges of entity_mem_ are resolved in parallel.
+// n_threads: 0 = one per hardware thread, 1 = calling thread only.
+// Timed by step-bench (cmake -DEXPRESS2CPP_BENCHMARK=ON).
+void resolve_entities(model&, unsigned n_threads);
+
+}  // namespace step
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <iosfwd>
-#include <memory>
+#include <cstdint>
 #include <string_view>
 #include <vector>
 
@@ -9,8 +8,16 @@
 
 namespace step {
 
+struct id_index;
+struct snapshot_reader;
+struct snapshot_writer;
+struct write_buffer;
 struct write_context;
 
+// Generated per schema: pre-order number of the entity in the subtype tree.
+// The type ids of all subtypes of T are in [T::TYPE_ID, T::TYPE_ID_END).
+using type_id_t = std::uint32_t;
+
 struct root_entity {
   root_entity() = default;
   root_entity(root_entity const&) = delete;
@@ -19,17 +26,28 @@ struct root_entity {
   root_entity& operator=(root_entity&&) = delete;
   virtual ~root_entity();
   virtual std::string_view name() const = 0;
-  virtual void resolve(std::vector<root_entity*> const&) = 0;
-  virtual void write(write_context const&, std::ostream&,
+  virtual void resolve(id_index const&) = 0;
+  virtual void write(write_context const&, write_buffer&,
                      bool write_type_name) const = 0;
-  friend void write(write_context const& ctx, std::ostream& out,
+  virtual void save_snapshot(snapshot_writer&) const = 0;
+  virtual void load_snapshot(snapshot_reader&) = 0;
+  friend void write(write_context const& ctx, write_buffer& out,
                     root_entity const& e) {
     e.write(ctx, out, true);
   }
-  std::size_t line_idx_{0U};
+
+  // T has to be a generated entity of this entity's schema.
+  template <typename T>
+  bool is_a() const {
+    return type_id_ >= T::TYPE_ID && type_id_ < T::TYPE_ID_END;
+  }
+
+  // Record of the entity in the parser input ("#1=...;"), relative to the
+  // start of the input. source_len_ is 0 for entities that were not parsed.
+  std::size_t source_offset_{0U};
   id_t id_;
+  type_id_t type_id_{0U};
+  std::uint32_t source_len_{0U};
 };
 
-using entity_ptr = std::unique_ptr<root_entity>;
-
 }  // namespace step
\ No newline at end of file
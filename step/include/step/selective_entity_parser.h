@@ -1,25 +1,32 @@
 #pragma once
 
-#include <functional>
-#include <optional>
-#include <string_view>
-#include <unordered_map>
+#include <vector>
 
 #include "utl/parser/cstr.h"
+#include "utl/verify.h"
 
+#include "step/arena.h"
+#include "step/entity_table.h"
+#include "step/parse_error.h"
 #include "step/root_entity.h"
 
 namespace step {
 
+// Parses the registered entity types only. Parse functions are stored in a
+// flat table indexed by the slot of the type name in the schema entity table.
 struct selective_entity_parser {
-  using parser_fn_t = std::function<entity_ptr(utl::cstr)>;
-  using parser_map_t = std::unordered_map<std::string_view, parser_fn_t>;
-
-  std::optional<entity_ptr> parse(utl::cstr type_name, utl::cstr rest) const {
-    if (auto const it = parsers_.find(type_name.view()); it != end(parsers_)) {
-      return it->second(rest);
+  explicit selective_entity_parser(entity_table const& table)
+      : table_{&table}, parsers_(table.n_slots_, nullptr) {}
+
+  // out stays nullptr for records that are not parsed.
+  parse_error parse(arena& mem, utl::cstr type_name, utl::cstr& rest,
+                    root_entity*& out) const {
+    out = nullptr;
+    auto const slot = table_->find(type_name.view());
+    if (!slot.has_value() || parsers_[*slot] == nullptr) {
+      return parse_error::kNone;
     }
-    return std::nullopt;
+    return parsers_[*slot](mem, rest, out);
   }
 
   template <typename... Ts>
@@ -29,14 +36,13 @@ struct selective_entity_parser {
 
   template <typename T>
   void register_parser() {
-    parsers_[T::NAME] = [](utl::cstr s) {
-      auto v = std::make_unique<T>();
-      parse_step(s, *v);
-      return v;
-    };
+    auto const slot = table_->find(T::NAME);
+    utl::verify(slot.has_value(), "unknown entity type {}", T::NAME);
+    parsers_[*slot] = &parse_entity<T>;
   }
 
-  parser_map_t parsers_;
+  entity_table const* table_;
+  std::vector<entity_parse_fn_t> parsers_;
 };
 
-}  // namespace step
\ No newline at end of file
+}  // namespace step
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "utl/parser/cstr.h"
+#include "utl/verify.h"
+
+#include "step/arena.h"
+#include "step/entity_cast.h"
+#include "step/has_data.h"
+#include "step/interned_string.h"
+#include "step/is_collection.h"
+#include "step/model.h"
+#include "step/root_entity.h"
+#include "step/string_ref.h"
+
+namespace step {
+
+// Binary snapshot of a model. Loading it skips all text parsing:
+//   header | (type id, id, source span) per entity | attributes per entity
+// Entity references are stored as index into the entity list (+1, 0 = null).
+// Values are stored in host byte order.
+constexpr auto const kSnapshotMagic = std::uint64_t{0x50414e5350455453ULL};
+constexpr auto const kSnapshotVersion = std::uint32_t{2U};
+
+using entity_create_fn_t = root_entity* (*)(arena&);
+
+template <typename T>
+root_entity* create_entity(arena& mem) {
+  return mem.create<T>();
+}
+
+// Generated per schema: create functions indexed by type id.
+struct snapshot_schema {
+  std::uint64_t hash_;
+  entity_create_fn_t const* create_;
+  std::size_t n_types_;
+};
+
+struct snapshot_writer {
+  template <typename T>
+  void write_pod(T const& v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out_.write(reinterpret_cast<char const*>(&v), sizeof(T));
+  }
+
+  void write_bytes(std::string_view);
+
+  std::ostream& out_;
+  std::unordered_map<root_entity const*, std::uint32_t> ptr_to_idx_;
+};
+
+struct snapshot_reader {
+  template <typename T>
+  T read_pod() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T v;
+    std::memcpy(&v, read_bytes(sizeof(T)).data(), sizeof(T));
+    return v;
+  }
+
+  std::string_view read_bytes(std::size_t);
+
+  utl::cstr in_;
+  model& m_;
+};
+
+template <typename T>
+void save(snapshot_writer& w, T const& v) {
+  using Type = std::decay_t<T>;
+  if constexpr (std::is_pointer_v<Type>) {
+    if (v == nullptr) {
+      w.write_pod(std::uint32_t{0U});
+    } else {
+      auto const it = w.ptr_to_idx_.find(static_cast<root_entity const*>(v));
+      utl::verify(it != end(w.ptr_to_idx_), "snapshot: entity not in model");
+      w.write_pod(it->second + 1U);
+    }
+  } else if constexpr (std::is_same_v<std::string, Type> ||
+                       std::is_same_v<string_ref, Type> ||
+                       std::is_same_v<interned_string, Type>) {
+    auto const str = std::string_view{v};
+    w.write_pod(static_cast<std::uint32_t>(str.size()));
+    w.write_bytes(str);
+  } else if constexpr (has_data<Type>::value) {
+    w.write_pod(static_cast<std::uint8_t>(v.data_.index()));
+    std::visit([&](auto const& data) { save(w, data); }, v.data_);
+  } else if constexpr (is_collection<Type>::value) {
+    w.write_pod(static_cast<std::uint32_t>(v.size()));
+    for (auto const& el : v) {
+      save(w, el);
+    }
+  } else {
+    w.write_pod(v);
+  }
+}
+
+template <typename T>
+void save(snapshot_writer& w, std::optional<T> const& v) {
+  w.write_pod(static_cast<std::uint8_t>(v.has_value()));
+  if (v.has_value()) {
+    save(w, *v);
+  }
+}
+
+template <typename T>
+void load(snapshot_reader&, T&);
+
+namespace detail {
+
+template <typename Variant, std::size_t... I>
+void load_alternative(snapshot_reader& r, Variant& v, std::size_t const idx,
+                      std::index_sequence<I...>) {
+  auto const found =
+      ((idx == I ? (load(r, v.template emplace<I>()), true) : false) || ...);
+  utl::verify(found, "snapshot: invalid alternative {}", idx);
+}
+
+}  // namespace detail
+
+template <typename T>
+void load(snapshot_reader& r, T& v) {
+  if constexpr (std::is_pointer_v<T>) {
+    auto const idx = r.read_pod<std::uint32_t>();
+    utl::verify(idx <= r.m_.entity_mem_.size(), "snapshot: invalid reference");
+    if (idx == 0U) {
+      v = nullptr;
+    } else {
+      v = entity_cast<std::remove_pointer_t<T>>(r.m_.entity_mem_[idx - 1U]);
+      utl::verify(v != nullptr, "snapshot: reference to entity of wrong type");
+    }
+  } else if constexpr (std::is_same_v<std::string, T> ||
+                       std::is_same_v<string_ref, T> ||
+                       std::is_same_v<interned_string, T>) {
+    auto const str = r.read_bytes(r.read_pod<std::uint32_t>());
+    if constexpr (std::is_same_v<std::string, T>) {
+      v = std::string{str};
+    } else if constexpr (std::is_same_v<string_ref, T>) {
+      auto* const mem = r.m_.arena_.allocate_bytes(str.size());
+      std::memcpy(mem, str.data(), str.size());
+      v = string_ref{mem, str.size()};
+    } else {
+      v = r.m_.strings_.intern(str);
+    }
+  } else if constexpr (has_data<T>::value) {
+    using Variant = decltype(v.data_);
+    detail::load_alternative(
+        r, v.data_, r.read_pod<std::uint8_t>(),
+        std::make_index_sequence<std::variant_size_v<Variant>>{});
+  } else if constexpr (is_collection<T>::value) {
+    auto const size = r.read_pod<std::uint32_t>();
+    utl::verify(size <= v.max_size(), "snapshot: list too long");
+    v.resize(size);
+    for (auto& el : v) {
+      load(r, el);
+    }
+  } else {
+    v = r.read_pod<T>();
+  }
+}
+
+template <typename T>
+void load(snapshot_reader& r, std::optional<T>& v) {
+  if (r.read_pod<std::uint8_t>() != 0U) {
+    load(r, v.emplace());
+  } else {
+    v.reset();
+  }
+}
+
+void save_snapshot(std::ostream&, model const&, std::uint64_t schema_hash);
+
+// Throws if the snapshot was written for a different schema.
+model load_snapshot(utl::cstr, snapshot_schema const&);
+
+model load_snapshot_file(char const* path, snapshot_schema const&);
+
+}  // namespace step
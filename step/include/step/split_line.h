@@ -5,6 +5,7 @@
 #include "utl/parser/cstr.h"
 
 #include "step/id_t.h"
+#include "step/parse_error.h"
 
 namespace step {
 
@@ -13,6 +14,12 @@ struct line {
   utl::cstr name_, entity_;
 };
 
+// Splits a record "#id = NAME(attributes);" (see record_scanner) into id,
+// name and attributes. Returns std::nullopt for statements without id.
+// Sets err (and returns std::nullopt) for malformed records.
+std::optional<line> split_line(utl::cstr, parse_error& err);
+
+// Throws for malformed records.
 std::optional<line> split_line(utl::cstr);
 
-}  // namespace step
\ No newline at end of file
+}  // namespace step
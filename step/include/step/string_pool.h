@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+#include "step/arena.h"
+#include "step/interned_string.h"
+
+namespace step {
+
+// Thread-safe interning table. Sharded by hash, so parser threads rarely
+// wait for each other. Entries live as long as the pool.
+struct string_pool {
+  static constexpr auto const kShards = std::size_t{16U};
+
+  struct shard {
+    std::mutex mutex_;
+    std::unordered_set<std::string_view> strings_;
+    arena mem_;
+  };
+
+  string_pool();
+
+  interned_string intern(std::string_view);
+  std::size_t size() const;
+
+  // Invalidates all interned strings. Not thread-safe against intern().
+  void clear();
+
+  std::unique_ptr<shard[]> shards_;  // NOLINT
+};
+
+}  // namespace step
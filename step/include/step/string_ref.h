@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace step {
+
+// Non-owning STRING attribute (express-gen --string-ref). Points into the
+// parser input or, if the value had to be unescaped, into the model arena.
+struct string_ref {
+  string_ref() = default;
+  string_ref(char const* str, std::size_t const len) : str_{str}, len_{len} {}
+  explicit string_ref(std::string_view v) : str_{v.data()}, len_{v.size()} {}
+
+  std::string_view view() const { return {str_, len_}; }
+  operator std::string_view() const { return view(); }  // NOLINT
+  std::string str() const { return std::string{view()}; }
+
+  char const* data() const { return str_; }
+  std::size_t size() const { return len_; }
+  bool empty() const { return len_ == 0U; }
+
+  friend bool operator==(string_ref a, string_ref b) {
+    return a.view() == b.view();
+  }
+  friend bool operator!=(string_ref a, string_ref b) { return !(a == b); }
+  friend bool operator==(string_ref a, std::string_view b) {
+    return a.view() == b;
+  }
+  friend bool operator!=(string_ref a, std::string_view b) {
+    return !(a == b);
+  }
+  friend bool operator==(std::string_view a, string_ref b) { return b == a; }
+  friend bool operator!=(std::string_view a, string_ref b) { return b != a; }
+
+  char const* str_{nullptr};
+  std::size_t len_{0U};
+};
+
+}  // namespace step
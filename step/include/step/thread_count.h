@@ -0,0 +1,18 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+namespace step {
+
+// Entities per thread below which starting a thread costs more than it saves.
+constexpr auto const kMinEntitiesPerThread = std::size_t{16U * 1024U};
+
+// Resolves the threads_ option: 0 = one per hardware thread.
+inline unsigned thread_count(unsigned const threads) {
+  return threads == 0U ? std::max(std::thread::hardware_concurrency(), 1U)
+                       : threads;
+}
+
+}  // namespace step
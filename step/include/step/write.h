@@ -1,28 +1,64 @@
 #pragma once
 
+#include <iosfwd>
 #include <optional>
-#include <ostream>
+#include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
-
-#include "cista/type_hash/type_name.h"
+#include <vector>
 
 #include "utl/enumerate.h"
 #include "utl/verify.h"
 
+#include "step/exp_logical.h"
 #include "step/id_t.h"
+#include "step/interned_string.h"
 #include "step/is_collection.h"
+#include "step/ref.h"
+#include "step/string_ref.h"
+#include "step/write_buffer.h"
+#include "step/write_options.h"
 
 namespace step {
 
 struct model;
 struct root_entity;
 
+// Output ids of the written entities, looked up by root_entity::id_.
+// Ids below dense_.size() (all ids of densely numbered inputs) are an array
+// access, outliers are kept in sparse_. keep_ids_: ids are written as is.
 struct write_context {
-  std::unordered_map<root_entity*, step::id_t> ptr_to_id_;
+  static constexpr auto const kNoId = id_t::kInvalid;
+
+  void assign(id_t, id_t out_id);
+
+  id_t out_id(id_t const id) const {
+    if (keep_ids_) {
+      return id;
+    }
+    auto out = kNoId;
+    if (id.id_ < dense_.size()) {
+      out = dense_[id.id_];
+    } else if (auto const it = sparse_.find(id.id_); it != end(sparse_)) {
+      out = it->second;
+    }
+    utl::verify(out != kNoId, "could not resolve #{}", id.id_);
+    return out;
+  }
+
+  std::vector<unsigned> dense_;
+  std::unordered_map<unsigned, unsigned> sparse_;
+  bool keep_ids_{false};
 };
 
-void write(std::ostream&, model const&);
+void write(write_buffer&, model const&, write_options const& = {});
+
+// std::ostream adapter: output is passed on in large blocks.
+void write(std::ostream&, model const&, write_options const& = {});
+
+// Writes the model to the file (replaces existing files).
+void write_file(char const* path, model const&, write_options const& = {});
 
 template <class, typename = void>
 struct is_comparable : std::false_type {};
@@ -32,8 +68,11 @@ struct is_comparable<
     T, std::void_t<decltype(std::declval<T>() == std::declval<T>())>>
     : std::true_type {};
 
+// Writes '...' with quotes inside the string escaped as ''.
+void write_quoted(write_buffer&, std::string_view);
+
 template <typename T>
-void write(write_context const& ctx, std::ostream& out, T const& e) {
+void write(write_context const& ctx, write_buffer& out, T const& e) {
   using Type = std::decay_t<T>;
   if constexpr (std::is_base_of_v<root_entity, Type>) {
     e.write(ctx, out, true);
@@ -41,13 +80,20 @@ void write(write_context const& ctx, std::ostream& out, T const& e) {
     if (e == nullptr) {
       out << "*";
     } else {
-      auto const it = ctx.ptr_to_id_.find(e);
-      utl::verify(it != end(ctx.ptr_to_id_), "could not resolve {}* {}",
-                  cista::type_str<Type>(), static_cast<void const*>(e));
-      out << "#" << it->second.id_;
+      out << "#" << ctx.out_id(e->id_).id_;
+    }
+  } else if constexpr (is_ref<Type>::value) {
+    if (!e.valid()) {
+      out << "*";
+    } else {
+      out << "#" << ctx.out_id(e.id_).id_;
     }
-  } else if constexpr (std::is_same_v<std::string, Type>) {
-    out << '\'' << e << '\'';
+  } else if constexpr (std::is_same_v<std::string, Type> ||
+                       std::is_same_v<string_ref, Type> ||
+                       std::is_same_v<interned_string, Type>) {
+    write_quoted(out, e);
+  } else if constexpr (std::is_same_v<exp_logical, Type>) {
+    out << to_str(e);
   } else if constexpr (is_collection<Type>::value) {
     out << "(";
     for (auto const& [i, el] : utl::enumerate(e)) {
@@ -72,7 +118,7 @@ void write(write_context const& ctx, std::ostream& out, T const& e) {
 }
 
 template <typename T>
-void write(write_context const& ctx, std::ostream& out,
+void write(write_context const& ctx, write_buffer& out,
            std::optional<T> const& e) {
   if (e.has_value()) {
     write(ctx, out, *e);
@@ -81,4 +127,12 @@ void write(write_context const& ctx, std::ostream& out,
   }
 }
 
+// std::ostream adapter for single values.
+template <typename T>
+void write(write_context const& ctx, std::ostream& out, T const& e) {
+  auto buf = write_buffer{out};
+  write(ctx, buf, e);
+  buf.flush();
+}
+
 }  // namespace step
\ No newline at end of file
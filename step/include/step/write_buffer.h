@@ -0,0 +1,68 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace step {
+
+// Output of the STEP writer. Appends to a growable buffer and hands it to
+// the sink (std::ostream or FILE*) in large blocks. Without a sink, the
+// output stays in the buffer (view()).
+struct write_buffer {
+  static constexpr auto const kBlockSize = std::size_t{1024U * 1024U};
+
+  write_buffer() = default;
+  explicit write_buffer(std::ostream&);
+  explicit write_buffer(std::FILE*);
+  write_buffer(write_buffer const&) = delete;
+  write_buffer(write_buffer&&) = delete;
+  write_buffer& operator=(write_buffer const&) = delete;
+  write_buffer& operator=(write_buffer&&) = delete;
+  ~write_buffer();
+
+  write_buffer& operator<<(std::string_view s) {
+    buf_.append(s);
+    if (buf_.size() >= kBlockSize) {
+      flush();
+    }
+    return *this;
+  }
+
+  write_buffer& operator<<(char const* s) {
+    return *this << std::string_view{s};
+  }
+
+  write_buffer& operator<<(char const c) {
+    buf_.push_back(c);
+    return *this;
+  }
+
+  write_buffer& operator<<(bool const b) { return *this << (b ? '1' : '0'); }
+
+  // STEP REAL, exact: parsing the output yields the same value.
+  write_buffer& operator<<(double);
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T>, write_buffer&> operator<<(
+      T const i) {
+    char str[24];  // NOLINT
+    auto const [end, ec] = std::to_chars(std::begin(str), std::end(str), i);
+    return *this << std::string_view{str, static_cast<std::size_t>(end - str)};
+  }
+
+  // Passes the buffered output to the sink (no-op without sink).
+  void flush();
+
+  std::string_view view() const { return buf_; }
+
+  std::string buf_;
+  std::ostream* out_{nullptr};
+  std::FILE* file_{nullptr};
+};
+
+}  // namespace step
@@ -0,0 +1,24 @@
+#pragma once
+
+namespace step {
+
+struct write_options {
+  // Number of threads serializing entities. The output does not depend on it.
+  // 0 = one per hardware thread, 1 = serial writing on the calling thread.
+  unsigned threads_{1U};
+
+  // Write entities with their id (root_entity::id_) instead of #0..#n in
+  // entity_mem_ order. Entities added with model::add_entity already have
+  // fresh ids.
+  bool keep_ids_{false};
+
+  // Copy the records of parsed entities unchanged from model::input_ (parsed
+  // with parse_options::keep_input_; not available for models loaded from a
+  // snapshot). Only entities changed through model::modify / mark_dirty are
+  // serialized: direct changes to other parsed entities are not written.
+  // Implies keep_ids_: copied records reference the original ids.
+  // Comments between records are not copied.
+  bool incremental_{false};
+};
+
+}  // namespace step
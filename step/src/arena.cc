@@ -0,0 +1,169 @@
+#include "step/arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+namespace step {
+
+namespace detail {
+
+std::size_t next_slab_idx() {
+  static std::atomic_size_t idx{0U};
+  return idx++;
+}
+
+}  // namespace detail
+
+constexpr auto const kBlockSize = std::size_t{64U * 1024U};
+
+arena::arena(arena&& o) noexcept
+    : slabs_{std::move(o.slabs_)},
+      used_slabs_{std::move(o.used_slabs_)},
+      bytes_{std::move(o.bytes_)} {
+  o.slabs_.clear();
+  o.used_slabs_.clear();
+  o.bytes_.clear();
+}
+
+arena& arena::operator=(arena&& o) noexcept {
+  if (this != &o) {
+    destroy();
+    slabs_ = std::move(o.slabs_);
+    used_slabs_ = std::move(o.used_slabs_);
+    bytes_ = std::move(o.bytes_);
+    o.slabs_.clear();
+    o.used_slabs_.clear();
+    o.bytes_.clear();
+  }
+  return *this;
+}
+
+arena::~arena() { destroy(); }
+
+arena::slab& arena::get_slab(std::size_t const idx, std::size_t const obj_size,
+                             void (*destroy)(void*)) {
+  if (slabs_.size() <= idx) {
+    slabs_.resize(idx + 1U);
+  }
+  auto& s = slabs_[idx];
+  if (s.destroy_ == nullptr) {
+    s.obj_size_ = obj_size;
+    s.objs_per_block_ = std::max(kBlockSize / obj_size, std::size_t{1U});
+    s.destroy_ = destroy;
+  }
+  if (!s.used_) {
+    s.used_ = true;
+    used_slabs_.emplace_back(idx);
+  }
+  return s;
+}
+
+void* arena::allocate(slab& s) {
+  if (s.blocks_.empty()) {
+    s.blocks_.emplace_back();
+  }
+  if (s.blocks_[s.current_].used_ == s.objs_per_block_) {
+    ++s.current_;
+    if (s.current_ == s.blocks_.size()) {
+      s.blocks_.emplace_back();
+    }
+  }
+  auto& b = s.blocks_[s.current_];
+  if (b.mem_ == nullptr) {
+    b.mem_ = static_cast<unsigned char*>(
+        ::operator new(s.obj_size_ * s.objs_per_block_));
+  }
+  return b.mem_ + b.used_ * s.obj_size_;
+}
+
+char* arena::allocate_bytes(std::size_t const n) {
+  if (n > kBlockSize / 4U) {  // dedicated block, keep filling the current one
+    auto const b = block{static_cast<unsigned char*>(::operator new(n)), n};
+    bytes_.insert(bytes_.empty() ? end(bytes_) : std::prev(end(bytes_)), b);
+    return reinterpret_cast<char*>(b.mem_);
+  }
+  if (bytes_.empty() || bytes_.back().used_ + n > kBlockSize) {
+    bytes_.push_back(
+        block{static_cast<unsigned char*>(::operator new(kBlockSize)), 0U});
+  }
+  auto& b = bytes_.back();
+  auto* const mem = b.mem_ + b.used_;
+  b.used_ += n;
+  return reinterpret_cast<char*>(mem);
+}
+
+void arena::merge(arena&& o) {
+  if (slabs_.size() < o.slabs_.size()) {
+    slabs_.resize(o.slabs_.size());
+  }
+  for (auto const idx : o.used_slabs_) {
+    auto& from = o.slabs_[idx];
+    auto& to = get_slab(idx, from.obj_size_, from.destroy_);
+    if (to.blocks_.empty() ||
+        (to.current_ == 0U && to.blocks_.front().used_ == 0U)) {
+      std::swap(to.blocks_, from.blocks_);
+      std::swap(to.current_, from.current_);
+      continue;
+    }
+
+    // Place the used blocks of the other arena behind our used blocks.
+    // Our current block may stay partially filled.
+    auto const n_used = from.current_ + 1U;
+    auto const insert_pos = begin(to.blocks_) + to.current_ + 1;
+    to.blocks_.insert(insert_pos, begin(from.blocks_),
+                      begin(from.blocks_) + n_used);
+    to.current_ += n_used;
+    from.blocks_.erase(begin(from.blocks_), begin(from.blocks_) + n_used);
+    from.current_ = 0U;
+  }
+  o.used_slabs_.clear();
+  for (auto& s : o.slabs_) {
+    s.used_ = false;
+  }
+
+  bytes_.insert(begin(bytes_), begin(o.bytes_), end(o.bytes_));
+  o.bytes_.clear();
+}
+
+void arena::clear() {
+  for (auto const idx : used_slabs_) {
+    auto& s = slabs_[idx];
+    for (auto& b : s.blocks_) {
+      for (auto i = 0U; i != b.used_; ++i) {
+        s.destroy_(b.mem_ + i * s.obj_size_);
+      }
+      b.used_ = 0U;
+    }
+    s.current_ = 0U;
+    s.used_ = false;
+  }
+  used_slabs_.clear();
+
+  for (auto& b : bytes_) {
+    ::operator delete(b.mem_);
+  }
+  bytes_.clear();
+}
+
+std::size_t arena::size() const {
+  auto n = std::size_t{0U};
+  for (auto const idx : used_slabs_) {
+    for (auto const& b : slabs_[idx].blocks_) {
+      n += b.used_;
+    }
+  }
+  return n;
+}
+
+void arena::destroy() {
+  clear();
+  for (auto& s : slabs_) {
+    for (auto& b : s.blocks_) {
+      ::operator delete(b.mem_);
+    }
+  }
+  slabs_.clear();
+}
+
+}  // namespace step
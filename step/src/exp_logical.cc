@@ -4,13 +4,17 @@
 
 namespace step {
 
-std::ostream& operator<<(std::ostream& out, exp_logical const l) {
+std::string_view to_str(exp_logical const l) {
   switch (l) {
-    case exp_logical::EXP_FALSE: return out << ".F.";
-    case exp_logical::EXP_TRUE: return out << ".T.";
+    case exp_logical::EXP_FALSE: return ".F.";
+    case exp_logical::EXP_TRUE: return ".T.";
     case exp_logical::EXP_UNKNOWN: [[fallthrough]];
-    default: return out << ".U.";
+    default: return ".U.";
   }
 }
 
+std::ostream& operator<<(std::ostream& out, exp_logical const l) {
+  return out << to_str(l);
+}
+
 }  // namespace step
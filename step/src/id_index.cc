@@ -0,0 +1,47 @@
+#include "step/id_index.h"
+
+#include <algorithm>
+
+#include "utl/verify.h"
+
+namespace step {
+
+root_entity*& id_index::slot(unsigned const id) {
+  auto& p = directory_[id >> kPageBits];
+  if (p == nullptr) {
+    p = std::make_unique<page>();
+    p->fill(nullptr);
+  }
+  return (*p)[id & (kPageSize - 1U)];
+}
+
+void id_index::insert(id_t const id, root_entity* e) {
+  utl::verify(id != id_t::invalid(), "id_index: invalid id");
+
+  // The directory costs one pointer per page. Growing it is fine as long
+  // as it stays small compared to the number of entities.
+  auto const page_idx = std::size_t{id.id_ >> kPageBits};
+  if (page_idx >= directory_.size() &&
+      page_idx < std::max(kMinDirectorySize, size_ + 1U)) {
+    directory_.resize(page_idx + 1U);
+    for (auto it = begin(overflow_); it != end(overflow_);) {
+      if ((it->first >> kPageBits) < directory_.size()) {
+        slot(it->first) = it->second;
+        it = overflow_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  auto& s = page_idx < directory_.size() ? slot(id.id_) : overflow_[id.id_];
+  if (s == nullptr && e != nullptr) {
+    ++size_;
+  } else if (s != nullptr && e == nullptr) {
+    --size_;
+  }
+  s = e;
+  next_id_ = std::max(next_id_.id_, id.id_ + 1U);
+}
+
+}  // namespace step
@@ -0,0 +1,25 @@
+#include "step/map_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace step {
+
+cista::mmap map_file(char const* path) {
+  auto mem = cista::mmap{path, cista::mmap::protection::READ};
+#if defined(__unix__) || defined(__APPLE__)
+  if (mem.size() != 0U) {
+    // Advice only - failures are not an error.
+    auto* const addr = static_cast<void*>(mem.data());
+    ::madvise(addr, mem.size(), MADV_SEQUENTIAL);
+    ::madvise(addr, mem.size(), MADV_WILLNEED);
+#if defined(MADV_HUGEPAGE)
+    ::madvise(addr, mem.size(), MADV_HUGEPAGE);
+#endif
+  }
+#endif
+  return mem;
+}
+
+}  // namespace step
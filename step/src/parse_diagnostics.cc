@@ -0,0 +1,53 @@
+#include "step/parse_diagnostics.h"
+
+#include "fmt/core.h"
+
+namespace step {
+
+bool parse_diagnostics::report(std::size_t const line_idx,
+                               std::size_t const offset, id_t const id,
+                               std::string_view const type,
+                               parse_error const reason) {
+  ++n_errors_;
+  if (policy_ != error_policy::kCount) {
+    errors_.push_back(
+        parse_diagnostic{line_idx, offset, id, std::string{type}, reason});
+  }
+  if (policy_ == error_policy::kAbort) {
+    aborted_ = true;
+  }
+  return !aborted_;
+}
+
+void parse_diagnostics::append(parse_diagnostics const& o,
+                               std::size_t const line_offset,
+                               std::size_t const byte_offset) {
+  n_errors_ += o.n_errors_;
+  aborted_ = aborted_ || o.aborted_;
+  for (auto e : o.errors_) {
+    if (e.line_idx_ != parse_diagnostic::kUnknownLine) {
+      e.line_idx_ += line_offset;
+    }
+    e.offset_ += byte_offset;
+    errors_.emplace_back(std::move(e));
+  }
+}
+
+namespace detail {
+
+void print_parse_errors(parse_diagnostics const& diag) {
+  for (auto const& e : diag.errors_) {
+    if (e.line_idx_ == parse_diagnostic::kUnknownLine) {
+      fmt::print("unable to parse record #{} {} (offset {}): {}\n", e.id_.id_,
+                 e.type_, e.offset_, to_str(e.reason_));
+    } else {
+      fmt::print("unable to parse line {}: #{} {} (offset {}): {}\n",
+                 e.line_idx_ + 1U, e.id_.id_, e.type_, e.offset_,
+                 to_str(e.reason_));
+    }
+  }
+}
+
+}  // namespace detail
+
+}  // namespace step
@@ -0,0 +1,26 @@
+#include "step/parse_error.h"
+
+namespace step {
+
+std::string_view to_str(parse_error const e) {
+  switch (e) {
+    case parse_error::kNone: return "no error";
+    case parse_error::kBadRecord: return "bad record";
+    case parse_error::kExpectedId: return "expected id";
+    case parse_error::kExpectedInteger: return "expected integer";
+    case parse_error::kExpectedReal: return "expected real";
+    case parse_error::kExpectedBool: return "expected bool";
+    case parse_error::kExpectedLogical: return "expected logical";
+    case parse_error::kExpectedString: return "expected string";
+    case parse_error::kExpectedList: return "expected list";
+    case parse_error::kListTooLong: return "list too long";
+    case parse_error::kExpectedEnum: return "expected enum";
+    case parse_error::kUnknownEnumValue: return "unknown enum value";
+    case parse_error::kExpectedSelect: return "expected select";
+    case parse_error::kUnknownSelect: return "unknown select";
+    case parse_error::kIncompleteRecord: return "incomplete record";
+  }
+  return "unknown error";
+}
+
+}  // namespace step
@@ -0,0 +1,147 @@
+#include "step/parse_real.h"
+
+#include <charconv>
+#include <cstdint>
+#include <system_error>
+
+#if !defined(__cpp_lib_to_chars)  // no floating point std::from_chars
+#include <locale>
+#include <sstream>
+#include <string>
+#endif
+
+namespace step {
+
+namespace {
+
+constexpr auto const kMaxExactMantissa = std::uint64_t{1U} << 53U;
+constexpr auto const kMaxMantissaDigits = 19;
+constexpr auto const kMaxExactPow10 = 22;
+
+constexpr double const kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                   1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                   1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool is_digit(char const c) { return c >= '0' && c <= '9'; }
+
+// Clinger's fast path: mantissa and power of ten are both exactly
+// representable, so a single multiplication / division rounds correctly.
+bool fast_path(std::uint64_t mantissa, int const exp10, double& val) {
+  if (mantissa > kMaxExactMantissa) {
+    return false;
+  }
+  if (exp10 < 0) {
+    if (exp10 < -kMaxExactPow10) {
+      return false;
+    }
+    val = static_cast<double>(mantissa) / kPow10[-exp10];
+    return true;
+  }
+  if (exp10 > kMaxExactPow10) {
+    // 123E25 = 123000E22: move surplus exponent into the mantissa if exact.
+    for (auto e = exp10; e != kMaxExactPow10; --e) {
+      mantissa *= 10U;
+      if (mantissa > kMaxExactMantissa) {
+        return false;
+      }
+    }
+    val = static_cast<double>(mantissa) * kPow10[kMaxExactPow10];
+    return true;
+  }
+  val = static_cast<double>(mantissa) * kPow10[exp10];
+  return true;
+}
+
+bool slow_path(char const* first, char const* last, double& val) {
+#if defined(__cpp_lib_to_chars)
+  auto const [ptr, ec] = std::from_chars(first, last, val);
+  return ec == std::errc{} && ptr == last;
+#else
+  auto in = std::istringstream{std::string{first, last}};
+  in.imbue(std::locale::classic());
+  in >> val;
+  return !in.fail();
+#endif
+}
+
+}  // namespace
+
+parse_error parse_real(utl::cstr& s, double& val) {
+  auto const* const last = s.str + s.len;  // NOLINT
+  auto const* p = s.str;
+
+  auto const negative = p != last && *p == '-';
+  if (p != last && (*p == '-' || *p == '+')) {
+    ++p;
+  }
+  auto const* const number_begin = p;
+
+  auto mantissa = std::uint64_t{0U};
+  auto n_digits = 0;  // significant digits in mantissa
+  auto exp10 = 0;
+  auto exact = true;
+  auto any_digit = false;
+  auto const add_digit = [&](char const c) {
+    any_digit = true;
+    if (mantissa == 0U && c == '0') {
+      return;  // leading zero
+    }
+    if (n_digits == kMaxMantissaDigits) {
+      exact = false;
+      return;
+    }
+    mantissa = mantissa * 10U + static_cast<unsigned>(c - '0');
+    ++n_digits;
+  };
+
+  for (; p != last && is_digit(*p); ++p) {
+    add_digit(*p);
+    if (!exact) {
+      ++exp10;
+    }
+  }
+  if (p != last && *p == '.') {
+    ++p;
+    for (; p != last && is_digit(*p); ++p) {
+      add_digit(*p);
+      if (exact) {
+        --exp10;
+      }
+    }
+  }
+  if (!any_digit) {
+    return parse_error::kExpectedReal;
+  }
+
+  if (p != last && (*p == 'E' || *p == 'e')) {
+    ++p;
+    auto const exp_negative = p != last && *p == '-';
+    if (p != last && (*p == '-' || *p == '+')) {
+      ++p;
+    }
+    if (p == last || !is_digit(*p)) {
+      return parse_error::kExpectedReal;
+    }
+    auto exp = 0;
+    for (; p != last && is_digit(*p); ++p) {
+      if (exp < 100'000) {
+        exp = exp * 10 + (*p - '0');
+      }
+    }
+    exp10 += exp_negative ? -exp : exp;
+  }
+
+  if (mantissa == 0U) {
+    val = negative ? -0.0 : 0.0;
+  } else if (exact && fast_path(mantissa, exp10, val)) {
+    val = negative ? -val : val;
+  } else if (!slow_path(negative ? number_begin - 1 : number_begin, p, val)) {
+    return parse_error::kExpectedReal;
+  }
+  s.len -= static_cast<std::size_t>(p - s.str);
+  s.str = p;
+  return parse_error::kNone;
+}
+
+}  // namespace step
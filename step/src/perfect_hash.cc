@@ -0,0 +1,84 @@
+#include "step/perfect_hash.h"
+
+#include <algorithm>
+
+#include "utl/verify.h"
+
+namespace step {
+
+namespace {
+
+std::size_t next_power_of_two(std::size_t const n) {
+  auto p = std::size_t{1U};
+  while (p < n) {
+    p *= 2U;
+  }
+  return p;
+}
+
+}  // namespace
+
+perfect_hash build_perfect_hash(std::vector<std::string_view> const& keys) {
+  auto const n = keys.size();
+  auto ph = perfect_hash{};
+  ph.displacements_.resize(next_power_of_two(std::max(n / 4U, std::size_t{1U})),
+                           0U);
+  ph.slots_.resize(next_power_of_two(n + n / 4U + 1U), perfect_hash::kEmpty);
+
+  auto hashes = std::vector<cista::hash_t>(n);
+  for (auto i = std::size_t{0U}; i != n; ++i) {
+    hashes[i] = cista::hash(keys[i]);
+  }
+  auto sorted = hashes;
+  std::sort(begin(sorted), end(sorted));
+  utl::verify(std::adjacent_find(begin(sorted), end(sorted)) == end(sorted),
+              "perfect hash: keys with equal hash");
+
+  // Place large buckets first while most slots are still free.
+  auto buckets = std::vector<std::vector<std::uint32_t>>(
+      ph.displacements_.size());
+  for (auto i = std::size_t{0U}; i != n; ++i) {
+    buckets[(perfect_hash_mix(hashes[i]) >> 32U) & (buckets.size() - 1U)]
+        .emplace_back(static_cast<std::uint32_t>(i));
+  }
+  auto order = std::vector<std::size_t>(buckets.size());
+  for (auto i = std::size_t{0U}; i != order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(begin(order), end(order), [&](auto const a, auto const b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  auto slots = std::vector<std::size_t>{};
+  for (auto const b : order) {
+    if (buckets[b].empty()) {
+      break;
+    }
+    for (auto d = std::uint32_t{0U};; ++d) {
+      utl::verify(d != perfect_hash::kEmpty, "perfect hash: no displacement");
+      ph.displacements_[b] = d;
+      slots.clear();
+      auto const fits = std::all_of(
+          begin(buckets[b]), end(buckets[b]), [&](std::uint32_t const key) {
+            auto const s = perfect_hash_slot(
+                hashes[key], ph.displacements_.data(), ph.displacements_.size(),
+                ph.slots_.size());
+            if (ph.slots_[s] != perfect_hash::kEmpty ||
+                std::find(begin(slots), end(slots), s) != end(slots)) {
+              return false;
+            }
+            slots.emplace_back(s);
+            return true;
+          });
+      if (fits) {
+        for (auto i = std::size_t{0U}; i != slots.size(); ++i) {
+          ph.slots_[slots[i]] = buckets[b][i];
+        }
+        break;
+      }
+    }
+  }
+  return ph;
+}
+
+}  // namespace step
@@ -0,0 +1,89 @@
+#include "step/record_index.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "utl/verify.h"
+
+#include "step/record_scanner.h"
+#include "step/split_chunks.h"
+#include "step/thread_count.h"
+
+namespace step {
+
+namespace {
+
+void scan(utl::cstr const input, utl::cstr const chunk,
+          std::vector<record_index::entry>& out) {
+  auto scanner = record_scanner{chunk};
+  while (auto const r = scanner.next()) {
+    if (r->str_.len == 0U || r->str_[0] != '#') {
+      continue;
+    }
+    // Malformed records are skipped (references to them stay unresolved).
+    auto err = parse_error::kNone;
+    auto const split = split_line(r->str_, err);
+    if (split.has_value()) {
+      out.push_back(record_index::entry{
+          split->id_.id_, static_cast<std::uint32_t>(r->str_.len),
+          static_cast<std::size_t>(r->str_.str - input.str),
+          cista::hash(split->name_.view())});
+    }
+  }
+}
+
+}  // namespace
+
+record_index::record_index(utl::cstr const input, parse_options const& opt)
+    : input_{input} {
+  auto const n_threads = thread_count(opt.threads_);
+  if (n_threads == 1U) {
+    scan(input, input, entries_);
+  } else {
+    auto const chunks = split_chunks(input, n_threads);
+    auto scanned = std::vector<std::vector<entry>>(chunks.size());
+    auto workers = std::vector<std::thread>{};
+    for (auto i = 0U; i != chunks.size(); ++i) {
+      workers.emplace_back([&, i]() { scan(input, chunks[i], scanned[i]); });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    for (auto const& s : scanned) {
+      entries_.insert(end(entries_), begin(s), end(s));
+    }
+  }
+
+  auto const by_id = [](entry const& a, entry const& b) {
+    return a.id_ < b.id_;
+  };
+  if (!std::is_sorted(begin(entries_), end(entries_), by_id)) {
+    std::stable_sort(begin(entries_), end(entries_), by_id);
+  }
+}
+
+record_index::entry const* record_index::find(id_t const id) const {
+  auto const it = std::lower_bound(
+      begin(entries_), end(entries_), id.id_,
+      [](entry const& e, unsigned const x) { return e.id_ < x; });
+  return it == end(entries_) || it->id_ != id.id_ ? nullptr : &*it;
+}
+
+std::vector<id_t> record_index::ids_of(std::string_view const type_name) const {
+  auto const type = cista::hash(type_name);
+  auto ids = std::vector<id_t>{};
+  for (auto const& e : entries_) {
+    if (e.type_ == type) {
+      ids.emplace_back(e.id_);
+    }
+  }
+  return ids;
+}
+
+line record_index::split(entry const& e) const {
+  auto const split = split_line(str(e));
+  utl::verify(split.has_value(), "bad record: {}", str(e).view());
+  return *split;
+}
+
+}  // namespace step
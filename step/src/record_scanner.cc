@@ -0,0 +1,176 @@
+#include "step/record_scanner.h"
+
+#include <cctype>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define STEP_SCANNER_SSE2
+#endif
+
+namespace step {
+
+namespace {
+
+inline bool is_structural(char const c) {
+  return c == '\'' || c == ';' || c == '/' || c == '\n';
+}
+
+// First quote, ';', '/' or line break in [p, end), or end.
+char const* find_structural(char const* p, char const* const end) {
+#ifdef STEP_SCANNER_SSE2
+  auto const quote = _mm_set1_epi8('\'');
+  auto const semicolon = _mm_set1_epi8(';');
+  auto const slash = _mm_set1_epi8('/');
+  auto const newline = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    auto const block =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));  // NOLINT
+    auto const match = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                     _mm_cmpeq_epi8(block, semicolon)),
+        _mm_or_si128(_mm_cmpeq_epi8(block, slash),
+                     _mm_cmpeq_epi8(block, newline)));
+    auto const mask = static_cast<unsigned>(_mm_movemask_epi8(match));
+    if (mask != 0U) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (p != end && !is_structural(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+}  // namespace
+
+std::optional<record> record_scanner::next() {
+  auto const* p = in_.str;
+  auto const* const end = in_.str + in_.len;  // NOLINT
+  auto line_idx = line_idx_;
+
+  // Skip whitespace and comments in front of the record.
+  while (p != end) {
+    if (*p == '\n') {
+      ++line_idx;
+      ++p;
+    } else if (std::isspace(static_cast<unsigned char>(*p)) != 0) {
+      ++p;
+    } else if (*p == '/' && end - p >= 2 && p[1] == '*') {
+      auto const* c = p + 2;
+      while (end - c >= 2 && !(c[0] == '*' && c[1] == '/')) {
+        line_idx += *c == '\n' ? 1U : 0U;
+        ++c;
+      }
+      if (end - c < 2) {
+        break;  // unterminated comment: keep as rest
+      }
+      p = c + 2;
+    } else {
+      break;
+    }
+  }
+  in_ = utl::cstr{p, static_cast<std::size_t>(end - p)};
+  line_idx_ = line_idx;
+
+  auto const* const start = p;
+  auto in_string = false;
+  while (true) {
+    p = find_structural(p, end);
+    if (p == end) {
+      return std::nullopt;  // incomplete record
+    }
+    switch (*p) {
+      case '\n': ++line_idx; break;
+      case '\'': in_string = !in_string; break;
+      case ';':
+        if (!in_string) {
+          auto const r = record{
+              utl::cstr{start, static_cast<std::size_t>(p + 1 - start)},
+              line_idx_};
+          in_ = utl::cstr{p + 1, static_cast<std::size_t>(end - p - 1)};
+          line_idx_ = line_idx;
+          return r;
+        }
+        break;
+      case '/':
+        if (!in_string && end - p >= 2 && p[1] == '*') {
+          auto const* c = p + 2;
+          while (end - c >= 2 && !(c[0] == '*' && c[1] == '/')) {
+            line_idx += *c == '\n' ? 1U : 0U;
+            ++c;
+          }
+          if (end - c < 2) {
+            return std::nullopt;  // unterminated comment
+          }
+          p = c + 1;  // points to '/', skipped below
+        }
+        break;
+      default: break;
+    }
+    ++p;
+  }
+}
+
+void collect_references(utl::cstr const attributes, std::vector<id_t>& refs) {
+  auto const* p = attributes.str;
+  auto const* const end = attributes.str + attributes.len;  // NOLINT
+  auto in_string = false;
+  for (; p != end; ++p) {
+    if (*p == '\'') {
+      in_string = !in_string;
+    } else if (*p == '#' && !in_string) {
+      auto id = 0U;
+      auto const* digit = p + 1;
+      for (; digit != end && *digit >= '0' && *digit <= '9'; ++digit) {
+        id = id * 10U + static_cast<unsigned>(*digit - '0');
+      }
+      if (digit != p + 1) {
+        refs.emplace_back(id);
+      }
+      p = digit - 1;
+    }
+  }
+}
+
+char const* next_record_boundary(char const* const begin,
+                                 char const* const pos,
+                                 char const* const end) {
+  auto in_string = false;
+  for (auto const* p = find_structural(begin, end); p != end;
+       p = find_structural(p + 1, end)) {
+    switch (*p) {
+      case '\'': in_string = !in_string; break;
+      case ';':
+        if (!in_string && p >= pos) {
+          auto const* c = p + 1;
+          while (c != end && *c != '\n' &&
+                 std::isspace(static_cast<unsigned char>(*c)) != 0) {
+            ++c;
+          }
+          if (c == end) {
+            return end;
+          } else if (*c == '\n') {
+            return c + 1;
+          }
+        }
+        break;
+      case '/':
+        if (!in_string && end - p >= 2 && p[1] == '*') {
+          auto const* c = p + 2;
+          while (end - c >= 2 && !(c[0] == '*' && c[1] == '/')) {
+            ++c;
+          }
+          if (end - c < 2) {
+            return end;  // unterminated comment
+          }
+          p = c + 1;  // points to '/', skipped by the next search
+        }
+        break;
+      default: break;
+    }
+  }
+  return end;
+}
+
+}  // namespace step
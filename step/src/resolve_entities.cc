@@ -0,0 +1,38 @@
+#include "step/resolve_entities.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "step/model.h"
+#include "step/root_entity.h"
+#include "step/thread_count.h"
+
+namespace step {
+
+void resolve_entities(model& m, unsigned const n_threads) {
+  auto const resolve_range = [&](std::size_t const from, std::size_t const to) {
+    for (auto i = from; i != to; ++i) {
+      m.entity_mem_[i]->resolve(m.id_to_entity_);
+    }
+  };
+
+  auto const n = m.entity_mem_.size();
+  auto const n_ranges =
+      std::min(std::size_t{thread_count(n_threads)},
+               std::max(n / kMinEntitiesPerThread, std::size_t{1U}));
+  auto const range = [&](std::size_t const i) { return n * i / n_ranges; };
+
+  // The calling thread resolves the last range.
+  auto workers = std::vector<std::thread>{};
+  workers.reserve(n_ranges - 1U);
+  for (auto i = std::size_t{0U}; i != n_ranges - 1U; ++i) {
+    workers.emplace_back(resolve_range, range(i), range(i + 1U));
+  }
+  resolve_range(range(n_ranges - 1U), n);
+  for (auto& w : workers) {
+    w.join();
+  }
+}
+
+}  // namespace step
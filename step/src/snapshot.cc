@@ -0,0 +1,79 @@
+#include "step/snapshot.h"
+
+#include "utl/enumerate.h"
+
+#include "step/map_file.h"
+
+namespace step {
+
+void snapshot_writer::write_bytes(std::string_view const str) {
+  out_.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+std::string_view snapshot_reader::read_bytes(std::size_t const n) {
+  utl::verify(n <= in_.len, "snapshot: unexpected end of input");
+  auto const bytes = std::string_view{in_.str, n};
+  in_ = in_.substr(n);
+  return bytes;
+}
+
+void save_snapshot(std::ostream& out, model const& m,
+                   std::uint64_t const schema_hash) {
+  auto w = snapshot_writer{out, {}};
+  w.write_pod(kSnapshotMagic);
+  w.write_pod(kSnapshotVersion);
+  w.write_pod(schema_hash);
+  w.write_pod(static_cast<std::uint64_t>(m.entity_mem_.size()));
+  for (auto const& [i, e] : utl::enumerate(m.entity_mem_)) {
+    w.ptr_to_idx_.emplace(e, static_cast<std::uint32_t>(i));
+    w.write_pod(e->type_id_);
+    w.write_pod(e->id_.id_);
+    w.write_pod(static_cast<std::uint64_t>(e->source_offset_));
+    w.write_pod(e->source_len_);
+  }
+  for (auto const* e : m.entity_mem_) {
+    e->save_snapshot(w);
+  }
+}
+
+model load_snapshot(utl::cstr in, snapshot_schema const& schema) {
+  model m;
+  auto r = snapshot_reader{in, m};
+  utl::verify(r.read_pod<std::uint64_t>() == kSnapshotMagic,
+              "snapshot: bad magic");
+  utl::verify(r.read_pod<std::uint32_t>() == kSnapshotVersion,
+              "snapshot: unsupported version");
+  utl::verify(r.read_pod<std::uint64_t>() == schema.hash_,
+              "snapshot: schema hash mismatch");
+
+  // All entities exist before attributes are loaded: references are final.
+  auto const n_entities = r.read_pod<std::uint64_t>();
+  utl::verify(n_entities <= in.len, "snapshot: invalid entity count");
+  m.entity_mem_.reserve(n_entities);
+  for (auto i = std::uint64_t{0U}; i != n_entities; ++i) {
+    auto const type = r.read_pod<type_id_t>();
+    utl::verify(type < schema.n_types_ && schema.create_[type] != nullptr,
+                "snapshot: invalid type id {}", type);
+    auto* const e = schema.create_[type](m.arena_);
+    e->id_ = id_t{r.read_pod<unsigned>()};
+    e->source_offset_ =
+        static_cast<std::size_t>(r.read_pod<std::uint64_t>());
+    e->source_len_ = r.read_pod<std::uint32_t>();
+    m.entity_mem_.emplace_back(e);
+    m.id_to_entity_.insert(e->id_, e);
+  }
+  for (auto* const e : m.entity_mem_) {
+    e->load_snapshot(r);
+  }
+  utl::verify(r.in_.len == 0U, "snapshot: trailing data");
+  return m;
+}
+
+model load_snapshot_file(char const* path, snapshot_schema const& schema) {
+  auto const mem = map_file(path);
+  return load_snapshot(
+      utl::cstr{reinterpret_cast<char const*>(mem.data()), mem.size()},
+      schema);
+}
+
+}  // namespace step
@@ -0,0 +1,32 @@
+#include "step/split_chunks.h"
+
+#include <algorithm>
+
+#include "step/record_scanner.h"
+
+namespace step {
+
+std::vector<utl::cstr> split_chunks(utl::cstr in, std::size_t const n_chunks) {
+  std::vector<utl::cstr> chunks;
+  if (in.len == 0U) {
+    return chunks;
+  }
+
+  auto const target_size =
+      std::max(in.len / std::max(n_chunks, std::size_t{1U}), std::size_t{1U});
+  while (in.len != 0U) {
+    if (in.len <= target_size) {
+      chunks.emplace_back(in);
+      break;
+    }
+
+    auto const* const boundary = next_record_boundary(
+        in.str, in.str + target_size, in.str + in.len);  // NOLINT
+    auto const chunk_size = static_cast<std::size_t>(boundary - in.str);
+    chunks.emplace_back(in.str, chunk_size);
+    in += chunk_size;
+  }
+  return chunks;
+}
+
+}  // namespace step
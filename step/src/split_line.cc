@@ -1,34 +1,59 @@
 #include "step/split_line.h"
 
+#include "utl/verify.h"
+
 #include "step/parse_step.h"
 
 namespace step {
 
-std::optional<line> split_line(utl::cstr in) {
+std::optional<line> split_line(utl::cstr in, parse_error& err) {
+  err = parse_error::kNone;
   if (in.len == 0 || in[0] != '#') {
     return std::nullopt;
   }
 
   line output;
-  parse_step(in, output.id_);
+  err = parse_step(in, output.id_);
+  if (err != parse_error::kNone) {
+    return std::nullopt;
+  }
 
   in = in.skip_whitespace_front();
-  utl::verify(in.len > 3 && in[0] == '=', "no '=' found, got {}", in.view());
-
-  auto const params_end = in.view().find(");");
-  utl::verify(params_end != std::string_view::npos,
-              "end ');' not found, got {}", in.view());
+  if (in.len <= 3 || in[0] != '=') {
+    err = parse_error::kBadRecord;
+    return std::nullopt;
+  }
 
-  in = in.substr(1, utl::size{params_end - 1});
-  in = in.skip_whitespace_front();
+  // "= NAME(attributes);" -> "NAME(attributes"
+  in = in.substr(1).skip_whitespace_back();
+  if (in.len == 0 || in[in.len - 1] != ';') {
+    err = parse_error::kBadRecord;
+    return std::nullopt;
+  }
+  --in.len;
+  in = in.trim();
+  if (in.len == 0 || in[in.len - 1] != ')') {
+    err = parse_error::kBadRecord;
+    return std::nullopt;
+  }
+  --in.len;
 
   auto const bracket_pos = in.view().find('(');
-  utl::verify(bracket_pos != std::string_view::npos,
-              "no bracket '(' found in: {}", in.view());
+  if (bracket_pos == std::string_view::npos) {
+    err = parse_error::kBadRecord;
+    return std::nullopt;
+  }
 
   output.name_ = in.substr(0, utl::size{bracket_pos});
   output.entity_ = in.substr(bracket_pos + 1);
   return output;
 }
 
-}  // namespace step
\ No newline at end of file
+std::optional<line> split_line(utl::cstr const in) {
+  auto err = parse_error::kNone;
+  auto split = split_line(in, err);
+  utl::verify(err == parse_error::kNone, "{}: {}", to_str(err), in.view());
+  return split;
+}
+
+}  // namespace step
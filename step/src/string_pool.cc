@@ -0,0 +1,42 @@
+#include "step/string_pool.h"
+
+#include <cstring>
+#include <functional>
+
+namespace step {
+
+string_pool::string_pool() : shards_{std::make_unique<shard[]>(kShards)} {}
+
+interned_string string_pool::intern(std::string_view const s) {
+  if (s.empty()) {
+    return {};
+  }
+
+  auto& sh = shards_[std::hash<std::string_view>{}(s) % kShards];
+  auto const lock = std::lock_guard{sh.mutex_};
+  auto it = sh.strings_.find(s);
+  if (it == end(sh.strings_)) {
+    auto* const mem = sh.mem_.allocate_bytes(s.size());
+    std::memcpy(mem, s.data(), s.size());
+    it = sh.strings_.emplace(mem, s.size()).first;
+  }
+  return interned_string{&*it};
+}
+
+std::size_t string_pool::size() const {
+  auto n = std::size_t{0U};
+  for (auto i = std::size_t{0U}; i != kShards; ++i) {
+    auto const lock = std::lock_guard{shards_[i].mutex_};
+    n += shards_[i].strings_.size();
+  }
+  return n;
+}
+
+void string_pool::clear() {
+  for (auto i = std::size_t{0U}; i != kShards; ++i) {
+    shards_[i].strings_.clear();
+    shards_[i].mem_.clear();
+  }
+}
+
+}  // namespace step
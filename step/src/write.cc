@@ -1,22 +1,199 @@
 #include "step/write.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "utl/enumerate.h"
+#include "utl/verify.h"
 
 #include "step/model.h"
 #include "step/root_entity.h"
+#include "step/thread_count.h"
 
 namespace step {
 
-void write(std::ostream& out, model const& m) {
-  write_context ctx;
-  for (auto const& [i, e] : utl::enumerate(m.entity_mem_)) {
-    ctx.ptr_to_id_.emplace(e.get(), i);
+void write_quoted(write_buffer& out, std::string_view str) {
+  out << '\'';
+  for (auto quote = str.find('\''); quote != std::string_view::npos;
+       quote = str.find('\'')) {
+    out << str.substr(0U, quote + 1U) << '\'';
+    str.remove_prefix(quote + 1U);
+  }
+  out << str << '\'';
+}
+
+void write_context::assign(id_t const id, id_t const out_id) {
+  if (id.id_ < dense_.size()) {
+    dense_[id.id_] = out_id.id_;
+  } else {
+    sparse_[id.id_] = out_id.id_;
   }
-  for (auto const& [i, e] : utl::enumerate(m.entity_mem_)) {
-    out << "#" << i << " = ";
+}
+
+namespace {
+
+void write_entities(write_context const& ctx, write_buffer& out,
+                    model const& m, bool const incremental,
+                    std::size_t const from, std::size_t const to) {
+  for (auto i = from; i != to; ++i) {
+    auto const* const e = m.entity_mem_[i];
+    if (incremental && e->source_len_ != 0U && !m.is_dirty(*e)) {
+      out << m.input_.view().substr(e->source_offset_, e->source_len_)
+          << "\n";
+      continue;
+    }
+    out << "#";
+    if (ctx.keep_ids_) {
+      out << e->id_.id_;
+    } else {
+      out << i;
+    }
+    out << " = ";
     e->write(ctx, out, true);
     out << "\n";
   }
 }
 
+// Workers serialize ranges into their own buffers. The calling thread
+// passes finished buffers to the output in range order, so the output is
+// the same as written serially. Workers stay at most 2 * n_threads ranges
+// ahead of the output: a slow sink bounds the number of buffers held.
+void write_parallel(write_context const& ctx, write_buffer& out,
+                    model const& m, bool const incremental,
+                    unsigned const n_threads) {
+  struct range {
+    write_buffer buf_;
+    bool done_{false};
+  };
+
+  auto const n = m.entity_mem_.size();
+  auto const n_ranges = std::clamp(n / kMinEntitiesPerThread, std::size_t{1U},
+                                   std::size_t{n_threads} * 4U);
+  auto const bound = [&](std::size_t const i) { return n * i / n_ranges; };
+  auto ranges = std::vector<range>(n_ranges);
+
+  auto const window = std::size_t{n_threads} * 2U;
+  auto mutex = std::mutex{};
+  auto range_done = std::condition_variable{};  // also signals flushed ranges
+  auto next_range = std::size_t{0U};
+  auto flushed = std::size_t{0U};
+  auto error = std::exception_ptr{};
+  auto workers = std::vector<std::thread>{};
+  workers.reserve(n_threads);
+  for (auto t = 0U; t != n_threads; ++t) {
+    workers.emplace_back([&]() {
+      while (true) {
+        auto i = std::size_t{0U};
+        {
+          auto lock = std::unique_lock{mutex};
+          range_done.wait(lock, [&]() {
+            return next_range == n_ranges || next_range < flushed + window ||
+                   error != nullptr;
+          });
+          if (next_range == n_ranges || error != nullptr) {
+            return;
+          }
+          i = next_range++;
+        }
+        auto range_error = std::exception_ptr{};
+        try {
+          write_entities(ctx, ranges[i].buf_, m, incremental, bound(i),
+                         bound(i + 1U));
+        } catch (...) {
+          range_error = std::current_exception();
+        }
+        {
+          auto const lock = std::scoped_lock{mutex};
+          ranges[i].done_ = true;
+          if (range_error != nullptr && error == nullptr) {
+            error = range_error;
+          }
+        }
+        range_done.notify_all();
+      }
+    });
+  }
+
+  try {
+    for (auto& r : ranges) {
+      {
+        auto lock = std::unique_lock{mutex};
+        range_done.wait(lock, [&]() { return r.done_ || error != nullptr; });
+        if (error != nullptr) {
+          break;
+        }
+      }
+      out << r.buf_.view();
+      r.buf_.buf_ = std::string{};
+      {
+        auto const lock = std::scoped_lock{mutex};
+        ++flushed;
+      }
+      range_done.notify_all();
+    }
+  } catch (...) {
+    {
+      auto const lock = std::scoped_lock{mutex};
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+    range_done.notify_all();
+  }
+
+  for (auto& w : workers) {
+    w.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace
+
+void write(write_buffer& out, model const& m, write_options const& opt) {
+  utl::verify(!opt.incremental_ || m.input_.str != nullptr,
+              "incremental write: model input not available (keep_input_)");
+  auto const n = m.entity_mem_.size();
+  write_context ctx;
+  ctx.keep_ids_ = opt.keep_ids_ || opt.incremental_;
+  if (!ctx.keep_ids_) {
+    // Ids up to twice the number of entities are stored densely.
+    ctx.dense_.resize(std::min(std::size_t{m.id_to_entity_.next_id().id_},
+                               std::max(2U * n, std::size_t{1024U})),
+                      write_context::kNoId);
+    for (auto const& [i, e] : utl::enumerate(m.entity_mem_)) {
+      ctx.assign(e->id_, static_cast<unsigned>(i));
+    }
+  }
+
+  auto const n_threads = thread_count(opt.threads_);
+  if (n_threads == 1U || n < 2U * kMinEntitiesPerThread) {
+    write_entities(ctx, out, m, opt.incremental_, 0U, n);
+  } else {
+    write_parallel(ctx, out, m, opt.incremental_, n_threads);
+  }
+}
+
+void write(std::ostream& out, model const& m, write_options const& opt) {
+  auto buf = write_buffer{out};
+  write(buf, m, opt);
+  buf.flush();
+}
+
+void write_file(char const* path, model const& m, write_options const& opt) {
+  auto const file = std::unique_ptr<std::FILE, decltype(&std::fclose)>{
+      std::fopen(path, "wb"), &std::fclose};
+  utl::verify(file != nullptr, "could not open {}", path);
+  auto buf = write_buffer{file.get()};
+  write(buf, m, opt);
+  buf.flush();
+}
+
 }  // namespace step
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "step/write_buffer.h"
+
+#include <cctype>
+#include <cstdio>
+#include <ostream>
+
+#include "utl/verify.h"
+
+namespace step {
+
+write_buffer::write_buffer(std::ostream& out) : out_{&out} {
+  buf_.reserve(kBlockSize);
+}
+
+write_buffer::write_buffer(std::FILE* file) : file_{file} {
+  buf_.reserve(kBlockSize);
+}
+
+write_buffer::~write_buffer() {
+  try {
+    flush();
+  } catch (...) {
+  }
+}
+
+write_buffer& write_buffer::operator<<(double const d) {
+  // Shortest representation that parses back to d.
+  char str[32];  // NOLINT
+#if defined(__cpp_lib_to_chars)
+  auto const* const end = std::to_chars(std::begin(str), std::end(str), d).ptr;
+#else
+  auto const* const end = str + std::snprintf(str, sizeof(str), "%.17g", d);
+#endif
+  auto const number =
+      std::string_view{str, static_cast<std::size_t>(end - str)};
+
+  // STEP REAL: the decimal point is mandatory ("86." and "1.E-07").
+  auto const exp = number.find('e');
+  auto const mantissa = number.substr(0U, exp);
+  *this << mantissa;
+  if (mantissa.find('.') == std::string_view::npos &&
+      std::isdigit(static_cast<unsigned char>(mantissa.back())) != 0) {
+    *this << '.';
+  }
+  if (exp != std::string_view::npos) {
+    *this << 'E' << number.substr(exp + 1U);
+  }
+  return *this;
+}
+
+void write_buffer::flush() {
+  if (out_ != nullptr) {
+    out_->write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+  } else if (file_ != nullptr) {
+    auto const size = buf_.size();
+    auto const written = std::fwrite(buf_.data(), 1U, size, file_);
+    buf_.clear();
+    utl::verify(written == size, "write_buffer: write failed");
+  }
+}
+
+}  // namespace step
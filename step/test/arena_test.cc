@@ -0,0 +1,94 @@
+#include "doctest/doctest.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "step/arena.h"
+
+namespace {
+
+struct counted {
+  explicit counted(int& n_alive) : n_alive_{n_alive} { ++n_alive_; }
+  counted(counted const&) = delete;
+  counted(counted&&) = delete;
+  counted& operator=(counted const&) = delete;
+  counted& operator=(counted&&) = delete;
+  ~counted() { --n_alive_; }
+  int& n_alive_;
+  std::string payload_{"a string that does not fit into the SSO buffer"};
+};
+
+}  // namespace
+
+TEST_CASE("arena") {
+  auto n_alive = 0;
+
+  SUBCASE("same type objects are contiguous") {
+    step::arena mem;
+    auto* const a = mem.create<counted>(n_alive);
+    auto* const b = mem.create<counted>(n_alive);
+    auto* const c = mem.create<double>(1.0);
+    auto* const d = mem.create<counted>(n_alive);
+    CHECK(*c == 1.0);
+    CHECK(b == a + 1);
+    CHECK(d == b + 1);
+    CHECK(n_alive == 3);
+    CHECK(mem.size() == 4U);
+  }
+  CHECK(n_alive == 0);
+
+  SUBCASE("many blocks") {
+    step::arena mem;
+    for (auto i = 0U; i != 10'000U; ++i) {
+      mem.create<counted>(n_alive);
+    }
+    CHECK(n_alive == 10'000);
+    CHECK(mem.size() == 10'000U);
+
+    mem.clear();
+    CHECK(n_alive == 0);
+    CHECK(mem.size() == 0U);
+
+    mem.create<counted>(n_alive);
+    CHECK(n_alive == 1);
+  }
+  CHECK(n_alive == 0);
+
+  SUBCASE("merge") {
+    step::arena a;
+    auto* const x = a.create<counted>(n_alive);
+    {
+      step::arena b;
+      for (auto i = 0U; i != 5'000U; ++i) {
+        b.create<counted>(n_alive);
+      }
+      b.create<int>(1);
+      a.merge(std::move(b));
+      CHECK(b.size() == 0U);
+    }
+    CHECK(n_alive == 5'001);
+    CHECK(a.size() == 5'002U);
+    CHECK(x->payload_.size() > 15U);
+
+    a.create<counted>(n_alive);
+    CHECK(n_alive == 5'002);
+  }
+  CHECK(n_alive == 0);
+
+  SUBCASE("bytes") {
+    step::arena a;
+    auto* const small = a.allocate_bytes(4U);
+    std::memcpy(small, "abcd", 4U);
+    {
+      step::arena b;
+      auto* const large = b.allocate_bytes(1024U * 1024U);
+      std::memset(large, 'x', 1024U * 1024U);
+      a.merge(std::move(b));
+      CHECK(large[1024U * 1024U - 1U] == 'x');
+    }
+    auto* const next = a.allocate_bytes(4U);
+    CHECK(next == small + 4);
+    CHECK(std::string_view{small, 4U} == "abcd");
+  }
+}
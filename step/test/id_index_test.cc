@@ -0,0 +1,73 @@
+#include "doctest/doctest.h"
+
+#include <vector>
+
+#include "step/id_index.h"
+
+namespace {
+
+step::root_entity* entity(unsigned const i) {
+  return reinterpret_cast<step::root_entity*>(std::uintptr_t{i} * 8U + 8U);
+}
+
+}  // namespace
+
+TEST_CASE("id index") {
+  step::id_index index;
+  CHECK(index.find(0U) == nullptr);
+  CHECK(index.find(step::id_t::invalid()) == nullptr);
+  CHECK(index.next_id() == 0U);
+
+  SUBCASE("dense") {
+    for (auto i = 0U; i != 10'000U; ++i) {
+      index.insert(i, entity(i));
+    }
+    for (auto i = 0U; i != 10'000U; ++i) {
+      CHECK(index.find(i) == entity(i));
+    }
+    CHECK(index.find(10'000U) == nullptr);
+    CHECK(index.size() == 10'000U);
+    CHECK(index.next_id() == 10'000U);
+    CHECK(index.overflow_.empty());
+  }
+
+  SUBCASE("numbering starts at 10,000,000") {
+    constexpr auto const kOffset = 10'000'000U;
+    for (auto i = 0U; i != 20'000U; ++i) {
+      index.insert(kOffset + i, entity(i));
+    }
+    for (auto i = 0U; i != 20'000U; ++i) {
+      CHECK(index.find(kOffset + i) == entity(i));
+    }
+    CHECK(index.find(0U) == nullptr);
+    CHECK(index.size() == 20'000U);
+    CHECK(index.next_id() == kOffset + 20'000U);
+
+    // Directory: one pointer per 1024 ids, ~ 10k pointers <= #entities.
+    CHECK(index.directory_.size() <= index.size());
+    CHECK(index.overflow_.empty());
+  }
+
+  SUBCASE("outlier") {
+    index.insert(1U, entity(1U));
+    index.insert(96945U, entity(2U));
+    index.insert(4'000'000'000U, entity(3U));
+    CHECK(index.find(1U) == entity(1U));
+    CHECK(index.find(96945U) == entity(2U));
+    CHECK(index.find(4'000'000'000U) == entity(3U));
+    CHECK(index.find(4'000'000'001U) == nullptr);
+    CHECK(index.size() == 3U);
+    CHECK(index.next_id() == 4'000'000'001U);
+    CHECK(index.directory_.size() <= step::id_index::kMinDirectorySize);
+  }
+
+  SUBCASE("overwrite") {
+    index.insert(5U, entity(1U));
+    index.insert(5U, entity(2U));
+    CHECK(index.find(5U) == entity(2U));
+    CHECK(index.size() == 1U);
+    index.insert(5U, nullptr);
+    CHECK(index.find(5U) == nullptr);
+    CHECK(index.size() == 0U);
+  }
+}
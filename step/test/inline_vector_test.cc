@@ -0,0 +1,58 @@
+#include "doctest/doctest.h"
+
+#include <vector>
+
+#include "step/inline_vector.h"
+#include "step/parse_step.h"
+
+TEST_CASE("inline vector") {
+  step::inline_vector<double, 3> v;
+  CHECK(v.empty());
+  CHECK(v.capacity() == 3U);
+
+  v.push_back(1.0);
+  v.emplace_back(2.0);
+  CHECK(v.size() == 2U);
+  CHECK(v == std::vector{1.0, 2.0});
+  CHECK(std::vector{1.0, 2.0} == v);
+  CHECK(v != std::vector{1.0});
+
+  v = {4.0, 5.0, 6.0};
+  CHECK(v.back() == 6.0);
+  CHECK(v.at(0) == 4.0);
+  CHECK_THROWS(v.at(3));
+  CHECK_THROWS(v.push_back(7.0));
+
+  v.resize(1U);
+  CHECK(v == step::inline_vector<double, 3>{4.0});
+  v.resize(2U);
+  CHECK(v[1] == 0.0);  // no stale values after shrinking
+  v.clear();
+  CHECK(v.empty());
+}
+
+TEST_CASE("parse inline vector") {
+  using step::parse_step;
+
+  SUBCASE("numbers") {
+    step::inline_vector<double, 3> v;
+    auto s = utl::cstr{"(-0.5,1.,2.E1))"};
+    parse_step(s, v);
+    CHECK(v == std::vector{-0.5, 1.0, 20.0});
+    CHECK(s.view() == ")");
+  }
+
+  SUBCASE("ids") {
+    step::inline_vector<void*, 2> v;
+    auto s = utl::cstr{"(#1,#2)"};
+    parse_step(s, v);
+    REQUIRE(v.size() == 2U);
+    CHECK(reinterpret_cast<uintptr_t>(v[1]) == 2U);
+  }
+
+  SUBCASE("too many elements") {
+    step::inline_vector<double, 3> v;
+    auto s = utl::cstr{"(1.,2.,3.,4.)"};
+    CHECK(parse_step(s, v) == step::parse_error::kListTooLong);
+  }
+}
@@ -1,9 +1,25 @@
 #include "doctest/doctest.h"
 
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "step/write.h"
+
+#include "IFC2X3/IfcCalendarDate.h"
+#include "IFC2X3/IfcCartesianPoint.h"
 #include "IFC2X3/IfcColourRgb.h"
+#include "IFC2X3/IfcDirection.h"
 #include "IFC2X3/IfcFlowController.h"
+#include "IFC2X3/IfcMetric.h"
+#include "IFC2X3/IfcPolyLoop.h"
+#include "IFC2X3/IfcProduct.h"
 #include "IFC2X3/IfcProductRepresentation.h"
 #include "IFC2X3/IfcRepresentation.h"
+#include "IFC2X3/IfcRoot.h"
 #include "IFC2X3/IfcSite.h"
 #include "IFC2X3/IfcSurfaceStyle.h"
 #include "IFC2X3/IfcSurfaceStyleRendering.h"
@@ -72,6 +88,28 @@ TEST_CASE("parse id select") {
   CHECK(shading->SurfaceColour_->Blue_ == 0.2);
 }
 
+TEST_CASE("parse nested id select") {
+  constexpr auto const* const ifc_input =
+      R"(#1=IFCCALENDARDATE(17,10,2026);
+#2=IFCMETRIC('Deadline',$,.HARD.,$,$,$,$,.EQUALTO.,$,#1);
+#3=IFCCARTESIANPOINT((0.,0.,0.));
+#4=IFCMETRIC('Invalid',$,.HARD.,$,$,$,$,.EQUALTO.,$,#3);)";
+
+  auto model = IFC2X3::parse(ifc_input);
+  auto const& metric = model.get_entity<IFC2X3::IfcMetric>(2);
+  REQUIRE(metric.DataValue_.data_.index() == 0U);  // IfcDateTimeSelect
+  auto const& date_time = std::get<0>(metric.DataValue_.data_);
+  REQUIRE(date_time.data_.index() == 0U);  // IfcCalendarDate
+  auto* const date = std::get<0>(date_time.data_);
+  REQUIRE(date != nullptr);
+  CHECK(date->id_ == 1U);
+
+  // Entity type not part of the select: reference is not assigned.
+  auto const& invalid = model.get_entity<IFC2X3::IfcMetric>(4);
+  REQUIRE(invalid.DataValue_.data_.index() == 0U);
+  CHECK(std::get<0>(std::get<0>(invalid.DataValue_.data_).data_) == nullptr);
+}
+
 TEST_CASE("does not define ContainsElements Parameter") {
   constexpr auto const* const input =
       R"(#22=IFCSITE('21yqcJ2bbAHBf6yeMkCLmK',#5,'Site','Site',$,#23,$,$,.ELEMENT.,$,$,$,$,$);)";
@@ -91,4 +129,356 @@ TEST_CASE("defines ContainsElements Parameter") {
   CHECK(site.GlobalId_ == "2xNM1YvyH50w3CkBOfaqX1");
   CHECK(site.RefLatitude_ == std::vector{24, 28, 0});
   CHECK(site.RefLongitude_ == std::vector{54, 25, 0});
-}
\ No newline at end of file
+}
+
+TEST_CASE("parse ifc multi-threaded") {
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+  auto const serial = IFC2X3::parse(ifc_input);
+  for (auto const threads : {2U, 3U, 8U}) {
+    auto const parallel =
+        IFC2X3::parse(ifc_input, step::parse_options{threads});
+
+    REQUIRE(parallel.entity_mem_.size() == serial.entity_mem_.size());
+    CHECK(parallel.id_to_entity_.size() == serial.id_to_entity_.size());
+    CHECK(parallel.id_to_entity_.next_id() == serial.id_to_entity_.next_id());
+    for (auto i = 0U; i != serial.entity_mem_.size(); ++i) {
+      CHECK(parallel.entity_mem_[i]->id_ == serial.entity_mem_[i]->id_);
+      CHECK(parallel.entity_mem_[i]->name() == serial.entity_mem_[i]->name());
+      CHECK(parallel.entity_mem_[i]->source_offset_ ==
+            serial.entity_mem_[i]->source_offset_);
+      CHECK(parallel.entity_mem_[i]->source_len_ ==
+            serial.entity_mem_[i]->source_len_);
+    }
+
+    std::stringstream serial_out, parallel_out;
+    write(serial_out, serial);
+    write(parallel_out, parallel);
+    CHECK(serial_out.str() == parallel_out.str());
+
+    auto const& flow_ctrl =
+        parallel.get_entity<IFC2X3::IfcFlowController>(step::id_t{96945});
+    REQUIRE(flow_ctrl.Representation_.has_value());
+    CHECK((*flow_ctrl.Representation_)->Representations_.size() == 1);
+  }
+
+  // ";\n" inside strings and comments must not become a chunk boundary.
+  auto tricky_input = std::string{};
+  for (auto i = 1U; i != 100U; ++i) {
+    tricky_input += "#" + std::to_string(i) +
+                    "=IFCCOLOURRGB('x;\ny',0.,0.,0.);\n/* a;\t\n b */\n";
+  }
+  auto const tricky_serial = IFC2X3::parse(tricky_input);
+  REQUIRE(tricky_serial.entity_mem_.size() == 99U);
+  for (auto const threads : {2U, 3U, 8U}) {
+    auto const parallel =
+        IFC2X3::parse(tricky_input, step::parse_options{threads});
+    REQUIRE(parallel.entity_mem_.size() == tricky_serial.entity_mem_.size());
+    for (auto i = 1U; i != 100U; ++i) {
+      CHECK(parallel.get_entity<IFC2X3::IfcColourRgb>(i).Name_ ==
+            std::string{"x;\ny"});
+    }
+
+    std::stringstream serial_out, parallel_out;
+    write(serial_out, tricky_serial);
+    write(parallel_out, parallel);
+    CHECK(serial_out.str() == parallel_out.str());
+  }
+}
+
+TEST_CASE("resolve entities multi-threaded") {
+  // Enough entities to resolve on several threads.
+  constexpr auto const n = 40'000U;
+  auto ifc_input = std::string{};
+  for (auto i = 1U; i <= n; ++i) {
+    ifc_input += "#" + std::to_string(i + n) + "=IFCPOLYLOOP((#" +
+                 std::to_string(i) + ",#" + std::to_string(n + 1U - i) +
+                 "));\n#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+                 std::to_string(i) + ".,0.));\n";
+  }
+
+  auto const m = IFC2X3::parse(ifc_input, step::parse_options{4U});
+  REQUIRE(m.entity_mem_.size() == 2U * n);
+  auto n_correct = 0U;
+  for (auto i = 1U; i <= n; ++i) {
+    auto const& loop = m.get_entity<IFC2X3::IfcPolyLoop>(step::id_t{i + n});
+    n_correct += loop.Polygon_.size() == 2U &&
+                 loop.Polygon_[0] == m.id_to_entity_.find(step::id_t{i}) &&
+                 loop.Polygon_[1] == m.id_to_entity_.find(n + 1U - i);
+  }
+  CHECK(n_correct == n);
+}
+
+TEST_CASE("for each entity") {
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+
+  std::vector<unsigned> ids;
+  IFC2X3::for_each_entity(ifc_input, [&](step::root_entity const& e) {
+    ids.emplace_back(e.id_.id_);
+  });
+  REQUIRE(ids.size() == 26U);
+  CHECK(ids.front() == 96945U);
+  CHECK(ids.back() == 94167U);
+
+  SUBCASE("selective") {
+    auto n_flow_ctrls = 0U;
+    IFC2X3::for_each_entity<IFC2X3::IfcFlowController>(
+        ifc_input, [&](step::root_entity const& e) {
+          auto const& flow_ctrl =
+              dynamic_cast<IFC2X3::IfcFlowController const&>(e);
+          CHECK(flow_ctrl.GlobalId_ == "0Gkk91VZX968DF0GjbXoN4");
+          CHECK(step::unresolved_id(flow_ctrl.OwnerHistory_) == 2U);
+          REQUIRE(flow_ctrl.Representation_.has_value());
+          CHECK(step::unresolved_id(*flow_ctrl.Representation_) == 96951U);
+          ++n_flow_ctrls;
+        });
+    CHECK(n_flow_ctrls == 1U);
+  }
+
+  SUBCASE("stream") {
+    for (auto const block_size : {1U, 16U, 100U, 1024U * 1024U}) {
+      std::vector<unsigned> stream_ids;
+      std::stringstream in{ifc_input};
+      step::for_each_entity(
+          IFC2X3::full_parser{}, in,
+          [&](step::root_entity const& e) {
+            stream_ids.emplace_back(e.id_.id_);
+          },
+          block_size);
+      CHECK(stream_ids == ids);
+    }
+  }
+}
+
+TEST_CASE("parse file") {
+  auto const path = std::filesystem::temp_directory_path() /
+                    "express2cpp_parse_file_test.ifc";
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+  std::ofstream{path} << ifc_input;
+
+  SUBCASE("full") {
+    auto const model = IFC2X3::parse_file(path.string().c_str());
+    CHECK(model.input_mem_ == nullptr);
+    auto const& flow_ctrl =
+        model.get_entity<IFC2X3::IfcFlowController>(step::id_t{96945});
+    CHECK(flow_ctrl.GlobalId_ == "0Gkk91VZX968DF0GjbXoN4");
+    REQUIRE(flow_ctrl.Representation_.has_value());
+    CHECK((*flow_ctrl.Representation_)->Representations_.size() == 1);
+  }
+
+  SUBCASE("selective, keep input") {
+    auto opt = step::parse_options{};
+    opt.keep_input_ = true;
+    auto const model = IFC2X3::parse_file<IFC2X3::IfcFlowController>(
+        path.string().c_str(), opt);
+    CHECK(model.entity_mem_.size() == 1U);
+    CHECK(model.input_mem_ != nullptr);
+    CHECK(model.input_.view() == ifc_input);
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("parse sparse ids") {
+  constexpr auto const* const ifc_input =
+      R"(#10000000=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#10000001=IFCSURFACESTYLERENDERING(#10000000,$,$,$,$,$,$,$,.METAL.);
+#4000000000=IFCSURFACESTYLE('Default Surface',.BOTH.,(#10000001));)";
+
+  auto model = IFC2X3::parse(ifc_input);
+  CHECK(model.id_to_entity_.size() == 3U);
+  CHECK(model.id_to_entity_.directory_.size() <=
+        step::id_index::kMinDirectorySize);
+
+  auto const& surface_style =
+      model.get_entity<IFC2X3::IfcSurfaceStyle>(4'000'000'000U);
+  auto* const shading = std::get<0>(surface_style.Styles_.at(0).data_);
+  REQUIRE(shading != nullptr);
+  REQUIRE(shading->SurfaceColour_ != nullptr);
+  CHECK(shading->SurfaceColour_->id_ == 10'000'000U);
+
+  auto& added = model.add_entity<IFC2X3::IfcColourRgb>();
+  CHECK(added.id_ == 4'000'000'001U);
+  CHECK(&model.get_entity<IFC2X3::IfcColourRgb>(added.id_) == &added);
+}
+
+TEST_CASE("entity type ids") {
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+  auto model = IFC2X3::parse(ifc_input);
+
+  auto* const e = model.id_to_entity_.find(96945U);
+  REQUIRE(e != nullptr);
+  CHECK(e->type_id_ == IFC2X3::IfcFlowController::TYPE_ID);
+  CHECK(e->is_a<IFC2X3::IfcFlowController>());
+  CHECK(e->is_a<IFC2X3::IfcProduct>());
+  CHECK(e->is_a<IFC2X3::IfcRoot>());
+  CHECK(!e->is_a<IFC2X3::IfcRepresentation>());
+  CHECK(!e->is_a<IFC2X3::IfcSite>());
+
+  CHECK(step::entity_cast<IFC2X3::IfcProduct>(e) ==
+        dynamic_cast<IFC2X3::IfcProduct*>(e));
+  CHECK(step::entity_cast<IFC2X3::IfcSite>(e) == nullptr);
+  CHECK(step::entity_cast<IFC2X3::IfcSite>(
+            static_cast<step::root_entity*>(nullptr)) == nullptr);
+
+  struct my_controller : public IFC2X3::IfcFlowController {};
+  static_assert(step::has_type_id<IFC2X3::IfcFlowController>::value);
+  static_assert(!step::has_type_id<my_controller>::value);
+  CHECK(step::entity_cast<my_controller>(e) == nullptr);
+
+  CHECK_THROWS(model.get_entity<IFC2X3::IfcSite>(96945U));
+  CHECK(model.get_entity<IFC2X3::IfcProduct>(96945U).id_ == 96945U);
+}
+
+TEST_CASE("lazy model") {
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+
+  SUBCASE("index") {
+    auto const index = step::record_index{ifc_input};
+    CHECK(index.entries_.size() == 26U);
+    CHECK(index.find(96945U) != nullptr);
+    CHECK(index.find(1U) == nullptr);
+    CHECK(index.ids_of("IFCCARTESIANPOINT") ==
+          std::vector<step::id_t>{94165U, 94166U, 94167U, 96930U, 96938U});
+  }
+
+  SUBCASE("single entity") {
+    auto model = IFC2X3::parse_lazy(ifc_input);
+    CHECK(model.size() == 0U);
+    auto const& point = model.get_entity<IFC2X3::IfcCartesianPoint>(96938U);
+    CHECK(point.Coordinates_.at(0) == -55853.364335);
+    CHECK(model.size() == 1U);
+    CHECK(model.materialize(1U) == nullptr);
+  }
+
+  SUBCASE("references are resolved") {
+    auto model = IFC2X3::parse_lazy(ifc_input);
+    auto const& flow_ctrl = model.get_entity<IFC2X3::IfcFlowController>(96945U);
+    CHECK(flow_ctrl.GlobalId_ == "0Gkk91VZX968DF0GjbXoN4");
+    REQUIRE(flow_ctrl.Representation_.has_value());
+    CHECK((*flow_ctrl.Representation_)->Representations_.size() == 1);
+    CHECK(model.size() == 26U);  // every record is reachable
+  }
+
+  SUBCASE("multi-threaded") {
+    auto model = IFC2X3::parse_lazy(ifc_input, step::parse_options{2U});
+    auto found = std::vector<step::root_entity*>(4U);
+    auto workers = std::vector<std::thread>{};
+    for (auto i = 0U; i != found.size(); ++i) {
+      workers.emplace_back([&, i]() { found[i] = model.materialize(96945U); });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    REQUIRE(found[0] != nullptr);
+    for (auto const* e : found) {
+      CHECK(e == found[0]);
+    }
+  }
+}
+
+TEST_CASE("parse reachable") {
+  auto const ifc_input = ifc_str("0Gkk91VZX968DF0GjbXoN4");
+
+  SUBCASE("follows references") {
+    auto const selective = IFC2X3::parse<IFC2X3::IfcFlowController>(ifc_input);
+    auto const& unresolved =
+        selective.get_entity<IFC2X3::IfcFlowController>(96945U);
+    REQUIRE(unresolved.Representation_.has_value());
+    CHECK(*unresolved.Representation_ == nullptr);
+
+    auto const model =
+        IFC2X3::parse_reachable<IFC2X3::IfcFlowController>(ifc_input);
+    CHECK(model.entity_mem_.size() == 26U);
+    CHECK(model.entity_mem_.front()->id_ == 96945U);
+    CHECK(model.entity_mem_.back()->id_ == 94167U);
+    auto const& flow_ctrl = model.get_entity<IFC2X3::IfcFlowController>(96945U);
+    REQUIRE(flow_ctrl.Representation_.has_value());
+    REQUIRE(*flow_ctrl.Representation_ != nullptr);
+    CHECK((*flow_ctrl.Representation_)->Representations_.size() == 1);
+  }
+
+  SUBCASE("skips unreferenced records") {
+    auto const model = IFC2X3::parse_reachable<IFC2X3::IfcDirection>(
+        ifc_input, step::parse_options{2U});
+    CHECK(model.entity_mem_.size() == 5U);
+    for (auto const* e : model.entity_mem_) {
+      CHECK(e->is_a<IFC2X3::IfcDirection>());
+    }
+  }
+}
+
+TEST_CASE("parse diagnostics") {
+  constexpr auto const* const ifc_input =
+      R"(#1=IFCCARTESIANPOINT((0.,0.,0.));
+#2=IFCCARTESIANPOINT((0.,x,0.));
+#3=IFCDIRECTION((1.,0.,0.));
+#4=IFCSIUNIT(*,.LENGTHUNIT.,.MILLI.,.FURLONG.);
+#5 IFCDIRECTION((1.,0.,0.));
+#6=IFCDIRECTION((0.,1.,0.));
+)";
+
+  SUBCASE("skip") {
+    for (auto const threads : {1U, 2U, 3U}) {
+      auto diag = step::parse_diagnostics{};
+      auto opt = step::parse_options{threads};
+      opt.diagnostics_ = &diag;
+      auto const model = IFC2X3::parse(ifc_input, opt);
+      CHECK(model.entity_mem_.size() == 3U);
+      CHECK(diag.n_errors_ == 3U);
+      CHECK(!diag.aborted_);
+      REQUIRE(diag.errors_.size() == 3U);
+
+      auto const& point = diag.errors_[0];
+      CHECK(point.line_idx_ == 1U);
+      CHECK(point.id_ == 2U);
+      CHECK(point.type_ == "IFCCARTESIANPOINT");
+      CHECK(point.reason_ == step::parse_error::kExpectedReal);
+      CHECK(std::string_view{ifc_input}.substr(point.offset_, 3U) == "x,0");
+
+      CHECK(diag.errors_[1].line_idx_ == 3U);
+      CHECK(diag.errors_[1].reason_ == step::parse_error::kUnknownEnumValue);
+      CHECK(diag.errors_[2].line_idx_ == 4U);
+      CHECK(diag.errors_[2].reason_ == step::parse_error::kBadRecord);
+    }
+  }
+
+  SUBCASE("count") {
+    auto diag = step::parse_diagnostics{step::error_policy::kCount};
+    auto opt = step::parse_options{};
+    opt.diagnostics_ = &diag;
+    auto const model = IFC2X3::parse(ifc_input, opt);
+    CHECK(model.entity_mem_.size() == 3U);
+    CHECK(diag.n_errors_ == 3U);
+    CHECK(diag.errors_.empty());
+  }
+
+  SUBCASE("abort") {
+    for (auto const threads : {1U, 2U, 3U}) {
+      auto diag = step::parse_diagnostics{step::error_policy::kAbort};
+      auto opt = step::parse_options{threads};
+      opt.diagnostics_ = &diag;
+      auto const model = IFC2X3::parse(ifc_input, opt);
+      CHECK(model.entity_mem_.size() == 1U);
+      CHECK(diag.aborted_);
+      CHECK(diag.n_errors_ == 1U);
+      REQUIRE(diag.errors_.size() == 1U);
+      CHECK(diag.errors_[0].id_ == 2U);
+    }
+  }
+
+  SUBCASE("stream") {
+    for (auto const block_size : {1U, 16U, 1024U}) {
+      auto diag = step::parse_diagnostics{};
+      auto n_entities = 0U;
+      std::stringstream in{ifc_input};
+      step::for_each_entity(
+          IFC2X3::full_parser{}, in,
+          [&](step::root_entity const&) { ++n_entities; }, block_size, &diag);
+      CHECK(n_entities == 3U);
+      REQUIRE(diag.errors_.size() == 3U);
+      CHECK(diag.errors_[1].line_idx_ == 3U);
+      CHECK(std::string_view{ifc_input}.substr(diag.errors_[0].offset_, 3U) ==
+            "x,0");
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#include "doctest/doctest.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "step/perfect_hash.h"
+
+#include "IFC2X3/IfcDirection.h"
+#include "IFC2X3/IfcSIUnit.h"
+#include "IFC2X3/parser.h"
+
+TEST_CASE("perfect hash") {
+  auto strings = std::vector<std::string>{};
+  for (auto i = 0U; i != 1000U; ++i) {
+    strings.emplace_back("IFCTYPE" + std::to_string(i));
+  }
+  auto const keys =
+      std::vector<std::string_view>{begin(strings), end(strings)};
+  auto const ph = step::build_perfect_hash(keys);
+
+  auto slots = std::set<std::size_t>{};
+  for (auto i = 0U; i != keys.size(); ++i) {
+    auto const slot = ph.slot(keys[i]);
+    REQUIRE(slot < ph.slots_.size());
+    CHECK(ph.slots_[slot] == i);
+    slots.emplace(slot);
+  }
+  CHECK(slots.size() == keys.size());
+
+  CHECK_THROWS(step::build_perfect_hash({"A", "B", "A"}));
+}
+
+TEST_CASE("entity table") {
+  auto const& table = IFC2X3::entities();
+  auto const slot = table.find(IFC2X3::IfcDirection::NAME);
+  REQUIRE(slot.has_value());
+  CHECK(table.slots_[*slot].name_ == "IFCDIRECTION");
+  CHECK(table.find("IFCSIUNIT") != slot);
+  CHECK(!table.find("IFCDIRECTIONX").has_value());
+  CHECK(!table.find("").has_value());
+
+  // A name hashed to the slot of IFCDIRECTION is still rejected.
+  for (auto i = 0U;; ++i) {
+    auto const name = "X" + std::to_string(i);
+    if (step::perfect_hash_slot(cista::hash(name), table.displacements_,
+                                table.n_displacements_,
+                                table.n_slots_) == *slot) {
+      CHECK(!table.find(name).has_value());
+      break;
+    }
+  }
+}
@@ -0,0 +1,96 @@
+#include "doctest/doctest.h"
+
+#include <string>
+#include <vector>
+
+#include "step/record_scanner.h"
+#include "step/split_chunks.h"
+#include "step/split_line.h"
+
+namespace {
+
+std::vector<step::record> scan_all(utl::cstr in, utl::cstr& rest) {
+  auto records = std::vector<step::record>{};
+  auto scanner = step::record_scanner{in};
+  while (auto const r = scanner.next()) {
+    records.emplace_back(*r);
+  }
+  rest = scanner.in_;
+  return records;
+}
+
+}  // namespace
+
+TEST_CASE("record scanner") {
+  auto rest = utl::cstr{};
+
+  SUBCASE("records and header") {
+    constexpr auto const* const input = R"(ISO-10303-21;
+HEADER;
+FILE_NAME('a;b.ifc','2020-01-01T00:00:00',(''),(''),'','','');
+ENDSEC;
+DATA;
+#1=IFCCARTESIANPOINT((0.,0.,0.));
+#2= IFCDIRECTION((1.,0.,0.)) ;
+)";
+    auto const records = scan_all(input, rest);
+    REQUIRE(records.size() == 7U);
+    CHECK(records[2].str_.view() ==
+          "FILE_NAME('a;b.ifc','2020-01-01T00:00:00',(''),(''),'','','');");
+    CHECK(records[5].str_.view() == "#1=IFCCARTESIANPOINT((0.,0.,0.));");
+    CHECK(records[5].line_idx_ == 5U);
+    CHECK(records[6].str_.view() == "#2= IFCDIRECTION((1.,0.,0.)) ;");
+    CHECK(records[6].line_idx_ == 6U);
+    CHECK(rest.len == 0U);
+  }
+
+  SUBCASE("quotes, comments, multiple lines") {
+    constexpr auto const* const input =
+        "/* header; comment */ #10=IFCLABEL('it''s ); here');\n"
+        "#11=IFCSITE('a',\n  /* ; */ 'b');#12=IFCLABEL('x');\n";
+    auto const records = scan_all(input, rest);
+    REQUIRE(records.size() == 3U);
+    CHECK(records[0].str_.view() == "#10=IFCLABEL('it''s ); here');");
+    CHECK(records[1].str_.view() == "#11=IFCSITE('a',\n  /* ; */ 'b');");
+    CHECK(records[1].line_idx_ == 1U);
+    CHECK(records[2].str_.view() == "#12=IFCLABEL('x');");
+    CHECK(records[2].line_idx_ == 2U);
+
+    auto const split = step::split_line(records[0].str_);
+    REQUIRE(split.has_value());
+    CHECK(split->id_ == 10U);
+    CHECK(split->name_.view() == "IFCLABEL");
+    CHECK(split->entity_.view() == "'it''s ); here'");
+  }
+
+  SUBCASE("incomplete record") {
+    auto const records = scan_all("#1=A(1);\n#2=B('x;", rest);
+    REQUIRE(records.size() == 1U);
+    CHECK(rest.view() == "#2=B('x;");
+  }
+
+  SUBCASE("long records") {
+    auto input = std::string{};
+    for (auto i = 0U; i != 100U; ++i) {
+      input += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+               std::string(i, '1') + ".,2.,3.));\n";
+    }
+    auto const records = scan_all(input, rest);
+    REQUIRE(records.size() == 100U);
+    for (auto i = 0U; i != 100U; ++i) {
+      CHECK(records[i].line_idx_ == i);
+      CHECK(records[i].str_.view().back() == ';');
+    }
+
+    auto const chunks = step::split_chunks(input, 7U);
+    for (auto const& c : chunks) {
+      CHECK(c.view().substr(c.len - 2U) == ";\n");
+    }
+  }
+}
+
+TEST_CASE("collect references") {
+  auto refs = std::vector<step::id_t>{};
+  step::collect_references("#1,'#2',(#30,$),'it''s #4',#5", refs);
+  CHECK(refs == std::vector<step::id_t>{1U, 30U, 5U});
+}
@@ -0,0 +1,85 @@
+#include "doctest/doctest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "step/snapshot.h"
+#include "step/write.h"
+
+#include "IFC2X3/IfcPropertySingleValue.h"
+#include "IFC2X3/IfcSurfaceStyle.h"
+#include "IFC2X3/IfcSurfaceStyleRendering.h"
+#include "IFC2X3/parser.h"
+
+namespace {
+
+constexpr auto const* const snapshot_input =
+    R"(#200158=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#200159=IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+#200160=IFCSURFACESTYLE('it''s',.BOTH.,(#200159));
+#564425=IFCPROPERTYSINGLEVALUE('MaterialThickness','',IFCPOSITIVELENGTHMEASURE(86.),$);
+)";
+
+std::string write_str(step::model const& m) {
+  std::stringstream ss;
+  write(ss, m);
+  return ss.str();
+}
+
+}  // namespace
+
+TEST_CASE("snapshot round trip") {
+  auto const m = IFC2X3::parse(snapshot_input);
+
+  std::stringstream ss;
+  IFC2X3::save_snapshot(ss, m);
+  auto const snapshot = ss.str();
+
+  auto const loaded = IFC2X3::load_snapshot(snapshot);
+  REQUIRE(loaded.entity_mem_.size() == m.entity_mem_.size());
+  CHECK(write_str(loaded) == write_str(m));
+
+  auto const& style = loaded.get_entity<IFC2X3::IfcSurfaceStyle>(200160U);
+  CHECK(style.Name_ == std::string{"it's"});
+  REQUIRE(style.Styles_.size() == 1U);
+  auto* const rendering =
+      &loaded.get_entity<IFC2X3::IfcSurfaceStyleRendering>(200159U);
+  CHECK(std::get<IFC2X3::IfcSurfaceStyleShading*>(style.Styles_[0].data_) ==
+        rendering);
+
+  auto const& value =
+      loaded.get_entity<IFC2X3::IfcPropertySingleValue>(564425U);
+  CHECK(value.NominalValue_.has_value());
+  CHECK(!value.Unit_.has_value());
+}
+
+TEST_CASE("snapshot schema mismatch") {
+  std::stringstream ss;
+  step::save_snapshot(ss, IFC2X3::parse(snapshot_input),
+                      IFC2X3::SCHEMA_HASH + 1U);
+  CHECK_THROWS(IFC2X3::load_snapshot(ss.str()));
+
+  std::stringstream valid;
+  IFC2X3::save_snapshot(valid, IFC2X3::parse(snapshot_input));
+  auto const truncated = valid.str().substr(0U, valid.str().size() - 1U);
+  CHECK_THROWS(IFC2X3::load_snapshot(truncated));
+}
+
+TEST_CASE("snapshot reference of wrong type") {
+  std::stringstream ss;
+  IFC2X3::save_snapshot(ss, IFC2X3::parse(snapshot_input));
+  auto snapshot = ss.str();
+
+  // header | 4 * (type id, id, offset, length) | IfcColourRgb (Name_ flag,
+  // 3 doubles) | SurfaceColour_ of IfcSurfaceStyleRendering
+  auto const ref_offset = 28U + 4U * 20U + 25U;
+  auto ref = std::uint32_t{};
+  std::memcpy(&ref, snapshot.data() + ref_offset, sizeof(ref));
+  REQUIRE(ref == 1U);  // index of IfcColourRgb + 1
+
+  ref = 3U;  // IfcSurfaceStyle
+  std::memcpy(snapshot.data() + ref_offset, &ref, sizeof(ref));
+  CHECK_THROWS(IFC2X3::load_snapshot(snapshot));
+}
@@ -0,0 +1,62 @@
+#include "doctest/doctest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "step/string_pool.h"
+
+TEST_CASE("string pool") {
+  step::string_pool strings;
+
+  SUBCASE("equal strings share one entry") {
+    auto const a = strings.intern("MappedRepresentation");
+    auto const b = strings.intern(std::string{"Mapped"} + "Representation");
+    auto const c = strings.intern("Brep");
+    CHECK(a == b);
+    CHECK(a.entry_ == b.entry_);
+    CHECK(a != c);
+    CHECK(a == "MappedRepresentation");
+    CHECK(c.view() == "Brep");
+    CHECK(strings.size() == 2U);
+    CHECK(std::hash<step::interned_string>{}(a) ==
+          std::hash<step::interned_string>{}(b));
+  }
+
+  SUBCASE("empty string") {
+    auto const e = strings.intern("");
+    CHECK(e == step::interned_string{});
+    CHECK(e.empty());
+    CHECK(e.view().empty());
+    CHECK(strings.size() == 0U);
+  }
+
+  SUBCASE("clear") {
+    strings.intern("Body");
+    strings.intern("Brep");
+    strings.clear();
+    CHECK(strings.size() == 0U);
+    CHECK(strings.intern("Body") == "Body");
+    CHECK(strings.size() == 1U);
+  }
+
+  SUBCASE("concurrent") {
+    auto handles = std::vector<std::vector<step::interned_string>>(4U);
+    auto threads = std::vector<std::thread>{};
+    for (auto& h : handles) {
+      threads.emplace_back([&]() {
+        for (auto i = 0U; i != 1'000U; ++i) {
+          h.emplace_back(strings.intern("name " + std::to_string(i)));
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    CHECK(strings.size() == 1'000U);
+    for (auto i = 0U; i != 1'000U; ++i) {
+      CHECK(handles[0][i] == handles[3][i]);
+      CHECK(handles[1][i].view() == "name " + std::to_string(i));
+    }
+  }
+}
@@ -1,13 +1,20 @@
 #include "doctest/doctest.h"
 
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <string>
 
+#include "step/parse_real.h"
 #include "step/write.h"
 
 #include "IFC2X3/IfcActionSourceTypeEnum.h"
 #include "IFC2X3/IfcCartesianPoint.h"
+#include "IFC2X3/IfcColourRgb.h"
 #include "IFC2X3/IfcSurfaceStyle.h"
+#include "IFC2X3/IfcSurfaceStyleRendering.h"
 #include "IFC2X3/parser.h"
 
 TEST_CASE("write enum test") {
@@ -17,12 +24,32 @@ TEST_CASE("write enum test") {
   CHECK(ss.str() == ".DEAD_LOAD_G.");
 }
 
+TEST_CASE("write string test") {
+  std::stringstream ss;
+  write(step::write_context{}, ss, std::string{"it's"});
+  write(step::write_context{}, ss, step::string_ref{"'a'", 3U});
+  CHECK(ss.str() == "'it''s''''a'''");
+}
+
 TEST_CASE("write entity test") {
   std::stringstream ss;
   IFC2X3::IfcCartesianPoint p;
   p.Coordinates_ = {1, 2, 3};
   write(step::write_context{}, ss, p);
-  CHECK(ss.str() == "IFCCARTESIANPOINT((1, 2, 3));");
+  CHECK(ss.str() == "IFCCARTESIANPOINT((1., 2., 3.));");
+}
+
+TEST_CASE("write ref test") {
+  auto const r = step::ref<IFC2X3::IfcCartesianPoint>{step::id_t{5U}};
+  auto ctx = step::write_context{};
+  std::stringstream unknown;
+  CHECK_THROWS(write(ctx, unknown, r));
+
+  std::stringstream ss;
+  ctx.keep_ids_ = true;
+  write(ctx, ss, r);
+  write(ctx, ss, step::ref<IFC2X3::IfcCartesianPoint>{});
+  CHECK(ss.str() == "#5*");
 }
 
 TEST_CASE("write model with references test") {
@@ -48,7 +75,7 @@ TEST_CASE("write model with select value test") {
   write(ss, IFC2X3::parse(ifc_input));
   auto const matches = ss.str() ==
                        "#0 = IFCPROPERTYSINGLEVALUE('MaterialThickness', '', "
-                       "IFCPOSITIVELENGTHMEASURE(86), $);\n";
+                       "IFCPOSITIVELENGTHMEASURE(86.), $);\n";
   CHECK(matches);
 }
 
@@ -61,4 +88,167 @@ TEST_CASE("write model with select value test") {
   auto const matches =
       ss.str() == "#0 = IFCSIUNIT(*, .LENGTHUNIT., .MILLI., .METRE.);\n";
   CHECK(matches);
-}
\ No newline at end of file
+}
+
+TEST_CASE("write model with sparse ids test") {
+  constexpr auto const* const ifc_input =
+      R"(#4000000000=IFCCOLOURRGB($,0.2,0.2,0.2);
+#7=IFCSURFACESTYLERENDERING(#4000000000,$,$,$,$,$,$,$,.METAL.);
+#3=IFCSURFACESTYLE('Default Surface',.BOTH.,(#7));)";
+
+  std::stringstream ss;
+  write(ss, IFC2X3::parse(ifc_input));
+  auto const matches = ss.str() == R"(#0 = IFCCOLOURRGB($, 0.2, 0.2, 0.2);
+#1 = IFCSURFACESTYLERENDERING(#0, $, $, $, $, $, $, $, .METAL.);
+#2 = IFCSURFACESTYLE('Default Surface', .BOTH., (#1));
+)";
+  CHECK(matches);
+}
+
+TEST_CASE("write model multi-threaded test") {
+  // Enough entities to be written in several ranges.
+  auto ifc_input = std::string{};
+  for (auto i = 1U; i <= 100'000U; ++i) {
+    ifc_input += "#" + std::to_string(i) + "=IFCCARTESIANPOINT((" +
+                 std::to_string(i) + ".5,0.));\n";
+    if (i % 2U == 0U) {
+      ifc_input += "#" + std::to_string(i + 1'000'000U) + "=IFCPOLYLOOP((#" +
+                   std::to_string(i) + ",#" + std::to_string(i - 1U) +
+                   "));\n";
+    }
+  }
+  auto const m = IFC2X3::parse(ifc_input);
+
+  std::stringstream serial;
+  write(serial, m);
+  for (auto const threads : {2U, 3U, 0U}) {
+    std::stringstream parallel;
+    write(parallel, m, step::write_options{threads});
+    CHECK(parallel.str() == serial.str());
+  }
+}
+
+TEST_CASE("write model keep ids test") {
+  constexpr auto const* const ifc_input =
+      R"(#200158=IFCCOLOURRGB($,0.2,0.2,0.2);
+#7=IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+#3=IFCSURFACESTYLE('Default Surface',.BOTH.,(#7));)";
+
+  auto m = IFC2X3::parse(ifc_input);
+  auto& p = m.add_entity<IFC2X3::IfcCartesianPoint>();
+  p.Coordinates_ = {1, 2};
+
+  auto opt = step::write_options{};
+  opt.keep_ids_ = true;
+  std::stringstream ss;
+  write(ss, m, opt);
+  auto const matches = ss.str() == R"(#200158 = IFCCOLOURRGB($, 0.2, 0.2, 0.2);
+#7 = IFCSURFACESTYLERENDERING(#200158, $, $, $, $, $, $, $, .METAL.);
+#3 = IFCSURFACESTYLE('Default Surface', .BOTH., (#7));
+#200159 = IFCCARTESIANPOINT((1., 2.));
+)";
+  CHECK(matches);
+}
+
+TEST_CASE("write model incremental test") {
+  constexpr auto const* const ifc_input =
+      R"(#200158=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#200159 = IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+/* comment */
+#200160=IFCSURFACESTYLE('Default Surface',.BOTH.,
+  (#200159));)";
+  auto const path = std::filesystem::temp_directory_path() /
+                    "express2cpp_write_incremental_test.ifc";
+  std::ofstream{path} << ifc_input;
+
+  auto parse_opt = step::parse_options{};
+  parse_opt.keep_input_ = true;
+  auto m = IFC2X3::parse_file(path.string().c_str(), parse_opt);
+  m.modify<IFC2X3::IfcColourRgb>(200158U).Red_ = 1.0;
+  m.add_entity<IFC2X3::IfcCartesianPoint>().Coordinates_ = {1, 2};
+
+  auto opt = step::write_options{};
+  opt.incremental_ = true;
+  std::stringstream ss;
+  write(ss, m, opt);
+  // The referring IFCSURFACESTYLERENDERING is copied: ids are kept.
+  auto const matches =
+      ss.str() == R"(#200158 = IFCCOLOURRGB($, 1., 0.2, 0.2);
+#200159 = IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+#200160=IFCSURFACESTYLE('Default Surface',.BOTH.,
+  (#200159));
+#200161 = IFCCARTESIANPOINT((1., 2.));
+)";
+  CHECK(matches);
+
+  std::filesystem::remove(path);
+
+  auto const from_memory = std::string{ifc_input};
+  auto const unchanged = IFC2X3::parse(from_memory, parse_opt);
+  std::stringstream unchanged_out;
+  write(unchanged_out, unchanged, opt);
+  CHECK(unchanged_out.str() ==
+        R"(#200158=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#200159 = IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+#200160=IFCSURFACESTYLE('Default Surface',.BOTH.,
+  (#200159));
+)");
+
+  // Only the referrer changes: the referenced colour is copied.
+  auto referrer = IFC2X3::parse(from_memory, parse_opt);
+  auto& added = referrer.add_entity<IFC2X3::IfcColourRgb>();
+  added.Red_ = added.Green_ = added.Blue_ = 0.5;
+  referrer.modify<IFC2X3::IfcSurfaceStyleRendering>(200159U).SurfaceColour_ =
+      &added;
+  std::stringstream referrer_out;
+  write(referrer_out, referrer, opt);
+  CHECK(referrer_out.str() ==
+        R"(#200158=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#200159 = IFCSURFACESTYLERENDERING(#200161, $, $, $, $, $, $, $, .METAL.);
+#200160=IFCSURFACESTYLE('Default Surface',.BOTH.,
+  (#200159));
+#200161 = IFCCOLOURRGB($, 0.5, 0.5, 0.5);
+)");
+
+  std::stringstream no_input;
+  CHECK_THROWS(write(no_input, IFC2X3::parse(from_memory), opt));
+}
+
+TEST_CASE("write buffer") {
+  step::write_buffer buf;
+  buf << "a" << 'b' << 42 << -7 << ' ' << 0.2 << ' ' << 86.0 << ' ' << 1e6
+      << ' ' << 57958.087044 << ' ' << to_str(step::exp_logical::EXP_TRUE);
+  CHECK(buf.view() == "ab42-7 0.2 86. 1.E+06 57958.087044 .T.");
+}
+
+TEST_CASE("write real round trip") {
+  for (auto const d : {0.1, 1.0 / 3.0, -55853.364335, -0.0, 1e-7, 123456789.0,
+                       5e-324, 1.7976931348623157e308}) {
+    step::write_buffer buf;
+    buf << d;
+    CHECK(buf.view().find('.') != std::string_view::npos);
+
+    auto s = utl::cstr{buf.view()};
+    auto parsed = 0.0;
+    REQUIRE(step::parse_real(s, parsed) == step::parse_error::kNone);
+    CHECK(s.len == 0U);
+    CHECK(parsed == d);
+  }
+}
+
+TEST_CASE("write file") {
+  constexpr auto const* const ifc_input =
+      R"(#200158=IFCCOLOURRGB($,0.200000,0.200000,0.200000);
+#200159=IFCSURFACESTYLERENDERING(#200158,$,$,$,$,$,$,$,.METAL.);
+#200160=IFCSURFACESTYLE('Default Surface',.BOTH.,(#200159));)";
+  auto const m = IFC2X3::parse(ifc_input);
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "express2cpp_write_file.ifc";
+  step::write_file(path.string().c_str(), m);
+
+  std::stringstream expected;
+  write(expected, m);
+  auto in = std::ifstream{path};
+  CHECK(std::string{std::istreambuf_iterator<char>{in}, {}} == expected.str());
+}